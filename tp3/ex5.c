@@ -13,18 +13,131 @@
 #define VAL_D 80
 #endif
 
+enum { BIND_ENV, BIND_MASTER, BIND_CLOSE, BIND_SPREAD };
+
 void random_number(double* array, int size) {
 	for (int i = 0; i < size; i++) {
 		array[i] = (double)rand() / (double)(RAND_MAX - 1);
 	}
 }
 
-int main() {
+// New value of x_courant[i]; returns |x[i] - x_courant[i]|
+static inline double jacobi_row(const double *a, const double *b, const double *x,
+		double *x_courant, int n, int i) {
+	double s = 0;
+	for (int j = 0; j < i; j++)
+		s += a[j * n + i] * x[j];
+	for (int j = i + 1; j < n; j++)
+		s += a[j * n + i] * x[j];
+	x_courant[i] = (b[i] - s) / a[i * n + i];
+	return fabs(x[i] - x_courant[i]);
+}
+
+// Sequential solve, identical to ex5_sequential.c
+int jacobi_sequential(const double *a, const double *b, double *x, double *x_courant,
+		int n, double *norme) {
+	int iteration = 0;
+	for (int i = 0; i < n; i++) x[i] = 1.0;
+	while (1) {
+		iteration++;
+		double absmax = 0;
+		for (int i = 0; i < n; i++) {
+			double curr = jacobi_row(a, b, x, x_courant, n, i);
+			if (curr > absmax) absmax = curr;
+		}
+		*norme = absmax / n;
+		if ((*norme <= DBL_EPSILON) || (iteration >= n)) break;
+		memcpy(x, x_courant, n * sizeof(double));
+	}
+	return iteration;
+}
+
+// Parallel solve with an explicit team size and binding policy. OMP_PLACES
+// is fixed when the runtime starts, but proc_bind can be chosen per region.
+int jacobi_bound(const double *a, const double *b, double *x, double *x_courant,
+		int n, int nthreads, int bind, double *norme) {
+	int iteration = 0;
+	for (int i = 0; i < n; i++) x[i] = 1.0;
+	while (1) {
+		iteration++;
+		double absmax = 0;
+		switch (bind) {
+		case BIND_MASTER:
+			#pragma omp parallel for num_threads(nthreads) proc_bind(master) reduction(max:absmax)
+			for (int i = 0; i < n; i++)
+				absmax = fmax(absmax, jacobi_row(a, b, x, x_courant, n, i));
+			break;
+		case BIND_CLOSE:
+			#pragma omp parallel for num_threads(nthreads) proc_bind(close) reduction(max:absmax)
+			for (int i = 0; i < n; i++)
+				absmax = fmax(absmax, jacobi_row(a, b, x, x_courant, n, i));
+			break;
+		case BIND_SPREAD:
+			#pragma omp parallel for num_threads(nthreads) proc_bind(spread) reduction(max:absmax)
+			for (int i = 0; i < n; i++)
+				absmax = fmax(absmax, jacobi_row(a, b, x, x_courant, n, i));
+			break;
+		default:
+			#pragma omp parallel for num_threads(nthreads) reduction(max:absmax)
+			for (int i = 0; i < n; i++)
+				absmax = fmax(absmax, jacobi_row(a, b, x, x_courant, n, i));
+			break;
+		}
+		*norme = absmax / n;
+		if ((*norme <= DBL_EPSILON) || (iteration >= n)) break;
+		memcpy(x, x_courant, n * sizeof(double));
+	}
+	return iteration;
+}
+
+// Sweep over thread counts (powers of two up to the number of processors)
+// and binding policies, timed against the sequential solver.
+void sweep(const double *a, const double *b, double *x, double *x_courant, int n, int diag) {
+	const char *bind_names[] = { "env", "master", "close", "spread" };
+	const char *places = getenv("OMP_PLACES");
+	int max_threads = omp_get_num_procs();
+	double norme;
+
+	fprintf(stdout, "# n=%d diag=%d OMP_PLACES=%s num_places=%d\n",
+		n, diag, places ? places : "(unset)", omp_get_num_places());
+
+	double t0 = omp_get_wtime();
+	int it_seq = jacobi_sequential(a, b, x, x_courant, n, &norme);
+	double t_seq = (omp_get_wtime() - t0) / it_seq;
+
+	fprintf(stdout, "threads,bind,iterations,time_per_iter,speedup,efficiency\n");
+	fprintf(stdout, "0,sequential,%d,%.6e,1.0000,1.0000\n", it_seq, t_seq);
+
+	for (int t = 1; ; t = (2 * t > max_threads && t < max_threads) ? max_threads : 2 * t) {
+		for (int bind = BIND_ENV; bind <= BIND_SPREAD; bind++) {
+			t0 = omp_get_wtime();
+			int it = jacobi_bound(a, b, x, x_courant, n, t, bind, &norme);
+			double t_iter = (omp_get_wtime() - t0) / it;
+			fprintf(stdout, "%d,%s,%d,%.6e,%.4f,%.4f\n",
+				t, bind_names[bind], it, t_iter, t_seq / t_iter, t_seq / t_iter / t);
+		}
+		if (t >= max_threads) break;
+	}
+}
+
+// Usage: ./ex5 [n [diag]] [--sweep]
+int main(int argc, char *argv[]) {
 	int n = VAL_N, diag = VAL_D;
 	int i, j, iteration = 0;
+	int do_sweep = 0, npos = 0;
 	double norme;
 
-	double *a = (double*)malloc(n * n * sizeof(double));
+	for (int k = 1; k < argc; k++) {
+		if (strcmp(argv[k], "--sweep") == 0) do_sweep = 1;
+		else if (npos == 0) { n = atoi(argv[k]); npos++; }
+		else if (npos == 1) { diag = atoi(argv[k]); npos++; }
+	}
+	if (n <= 0) {
+		fprintf(stderr, "System size must be positive\n");
+		exit(EXIT_FAILURE);
+	}
+
+	double *a = (double*)malloc((size_t)n * n * sizeof(double));
 	double *x = (double*)malloc(n * sizeof(double));
 	double *x_courant = (double*)malloc(n * sizeof(double));
 	double *b = (double*)malloc(n * sizeof(double));
@@ -51,6 +164,12 @@ int main() {
 		x[i] = 1.0;
 	}
 
+	if (do_sweep) {
+		sweep(a, b, x, x_courant, n, diag);
+		free(a); free(x); free(x_courant); free(b);
+		return EXIT_SUCCESS;
+	}
+
 	t_cpu_0 = omp_get_wtime();
 	gettimeofday(&t_elapsed_0, NULL);
 
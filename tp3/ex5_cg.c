@@ -0,0 +1,262 @@
+// Conjugate Gradient / Jacobi-preconditioned CG for the ex5.c system
+//
+// The matrix is generated exactly as in ex5.c (srand(421), random_number,
+// diagonal shifted by VAL_D) and then symmetrized, A = (A + A^T) / 2, so
+// that it is symmetric positive definite whenever it is diagonally dominant.
+// Jacobi, CG and PCG are run on the same system and stop on the same
+// relative residual ||b - A x|| / ||b|| <= tol.
+//
+// Each CG iteration makes three passes over the vectors:
+//   1. q = A p fused with p.q
+//   2. x += alpha p, r -= alpha q, z = r / diag(A), r.z and r.r in one loop
+//   3. p = z + beta p
+//
+// Compile: gcc -O2 -fopenmp ex5_cg.c -o ex5_cg -lm
+// Run:     ./ex5_cg [--n N] [--diag D] [--tol T] [--maxit M] [--log]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#ifndef VAL_N
+#define VAL_N 120
+#endif
+#ifndef VAL_D
+#define VAL_D 80
+#endif
+
+void random_number(double* array, int size) {
+	for (int i = 0; i < size; i++) {
+		array[i] = (double)rand() / (double)(RAND_MAX - 1);
+	}
+}
+
+// Same setup as ex5.c, followed by symmetrization.
+void setup_system(double *a, double *b, int n, int diag) {
+	srand(421);
+	random_number(a, n * n);
+	random_number(b, n);
+
+	for (int i = 0; i < n; i++) {
+		for (int j = i + 1; j < n; j++) {
+			double s = 0.5 * (a[i * n + j] + a[j * n + i]);
+			a[i * n + j] = s;
+			a[j * n + i] = s;
+		}
+	}
+
+	for (int i = 0; i < n; i++) {
+		a[i * n + i] += diag;
+	}
+}
+
+// q = A p, returns p.q
+double matvec_dot(const double *a, const double *p, double *q, int n) {
+	double pq = 0;
+	#pragma omp parallel for reduction(+:pq) schedule(static)
+	for (int i = 0; i < n; i++) {
+		double s = 0;
+		for (int j = 0; j < n; j++)
+			s += a[i * n + j] * p[j];
+		q[i] = s;
+		pq += p[i] * s;
+	}
+	return pq;
+}
+
+// x += alpha p, r -= alpha q, z = r / d (z == r when d is NULL),
+// returns r.z in *rz and r.r in *rr
+void update_fused(double *x, double *r, double *z, const double *p, const double *q,
+		const double *d, double alpha, int n, double *rz, double *rr) {
+	double s_rz = 0, s_rr = 0;
+	#pragma omp parallel for reduction(+:s_rz, s_rr) schedule(static)
+	for (int i = 0; i < n; i++) {
+		x[i] += alpha * p[i];
+		double ri = r[i] - alpha * q[i];
+		double zi = d ? ri / d[i] : ri;
+		r[i] = ri;
+		z[i] = zi;
+		s_rz += ri * zi;
+		s_rr += ri * ri;
+	}
+	*rz = s_rz;
+	*rr = s_rr;
+}
+
+// p = z + beta p
+void xpby(const double *z, double *p, double beta, int n) {
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < n; i++)
+		p[i] = z[i] + beta * p[i];
+}
+
+// Returns the iteration count; *res holds the final relative residual.
+int cg(const double *a, const double *b, double *x, const double *d, int n,
+		double tol, int maxit, int log, double *res) {
+	double *r = malloc(n * sizeof(double));
+	double *z = malloc(n * sizeof(double));
+	double *p = malloc(n * sizeof(double));
+	double *q = malloc(n * sizeof(double));
+	if (!r || !z || !p || !q) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// x0 = 0, so r0 = b
+	double rz = 0, rr = 0, bb;
+	#pragma omp parallel for reduction(+:rz, rr) schedule(static)
+	for (int i = 0; i < n; i++) {
+		x[i] = 0.0;
+		r[i] = b[i];
+		z[i] = d ? b[i] / d[i] : b[i];
+		p[i] = z[i];
+		rz += r[i] * z[i];
+		rr += r[i] * r[i];
+	}
+	bb = rr;
+
+	int iteration = 0;
+	double t_prev = omp_get_wtime();
+	while (sqrt(rr / bb) > tol && iteration < maxit) {
+		iteration++;
+		double pq = matvec_dot(a, p, q, n);
+		if (pq <= 0) {
+			fprintf(stderr, "CG breakdown (p.Ap = %e): matrix is not SPD\n", pq);
+			break;
+		}
+		double alpha = rz / pq;
+		double rz_new;
+		update_fused(x, r, z, p, q, d, alpha, n, &rz_new, &rr);
+		xpby(z, p, rz_new / rz, n);
+		rz = rz_new;
+
+		if (log) {
+			double t_now = omp_get_wtime();
+			fprintf(stdout, "  %s it %4d  residual %10.3E  time %10.3E sec.\n",
+				d ? "PCG" : "CG ", iteration, sqrt(rr / bb), t_now - t_prev);
+			t_prev = t_now;
+		}
+	}
+
+	*res = sqrt(rr / bb);
+	free(r); free(z); free(p); free(q);
+	return iteration;
+}
+
+// Jacobi sweep as in ex5.c; the residual at x falls out of the sweep for free.
+int jacobi(const double *a, const double *b, double *x, int n,
+		double tol, int maxit, int log, double *res) {
+	double *x_courant = malloc(n * sizeof(double));
+	if (!x_courant) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	double bb = 0;
+	for (int i = 0; i < n; i++) {
+		x[i] = 1.0;
+		bb += b[i] * b[i];
+	}
+
+	int iteration = 0;
+	double t_prev = omp_get_wtime();
+	while (1) {
+		double rr = 0;
+		#pragma omp parallel for reduction(+:rr) schedule(static)
+		for (int i = 0; i < n; i++) {
+			double s = 0;
+			for (int j = 0; j < n; j++)
+				s += a[i * n + j] * x[j];
+			double ri = b[i] - s;
+			rr += ri * ri;
+			x_courant[i] = x[i] + ri / a[i * n + i];
+		}
+		*res = sqrt(rr / bb);
+		if (log && iteration > 0) {
+			double t_now = omp_get_wtime();
+			fprintf(stdout, "  Jacobi it %4d  residual %10.3E  time %10.3E sec.\n",
+				iteration, *res, t_now - t_prev);
+			t_prev = t_now;
+		}
+		// Jacobi needs diagonal dominance; without it the iterate blows up
+		if (!isfinite(*res)) {
+			fprintf(stdout, "  Jacobi diverged at iteration %d (residual %E)\n",
+				iteration, *res);
+			break;
+		}
+		if (*res <= tol || iteration >= maxit) break;
+		iteration++;
+		memcpy(x, x_courant, n * sizeof(double));
+	}
+
+	free(x_courant);
+	return iteration;
+}
+
+int main(int argc, char *argv[]) {
+	int n = VAL_N, diag = VAL_D;
+	double tol = 1e-10;
+	int maxit = -1, log = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) n = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--diag") == 0 && i + 1 < argc) diag = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--tol") == 0 && i + 1 < argc) tol = atof(argv[++i]);
+		else if (strcmp(argv[i], "--maxit") == 0 && i + 1 < argc) maxit = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--log") == 0) log = 1;
+		else {
+			fprintf(stderr, "Usage: %s [--n N] [--diag D] [--tol T] [--maxit M] [--log]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (n <= 0) {
+		fprintf(stderr, "n must be positive\n");
+		return EXIT_FAILURE;
+	}
+	if (maxit < 0) maxit = n;
+
+	double *a = (double*)malloc((size_t)n * n * sizeof(double));
+	double *b = (double*)malloc(n * sizeof(double));
+	double *d = (double*)malloc(n * sizeof(double));
+	double *x = (double*)malloc(n * sizeof(double));
+
+	if (!a || !b || !d || !x) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	setup_system(a, b, n, diag);
+	for (int i = 0; i < n; i++) d[i] = a[i * n + i];
+
+	const char *names[] = { "Jacobi", "CG", "PCG (Jacobi)" };
+	int iterations[3];
+	double times[3], residuals[3];
+
+	for (int s = 0; s < 3; s++) {
+		double t0 = omp_get_wtime();
+		if (s == 0) iterations[s] = jacobi(a, b, x, n, tol, maxit, log, &residuals[s]);
+		else iterations[s] = cg(a, b, x, s == 2 ? d : NULL, n, tol, maxit, log, &residuals[s]);
+		times[s] = omp_get_wtime() - t0;
+	}
+
+	fprintf(stdout, "\n\nSystem size            : %5d\n"
+		"Threads                : %d\n"
+		"Tolerance              : %10.3E\n\n",
+		n, omp_get_max_threads(), tol);
+	fprintf(stdout, "%-14s %10s %12s %12s %12s %10s\n",
+		"Solver", "Iterations", "Residual", "Time (s)", "Time/iter", "vs Jacobi");
+	for (int s = 0; s < 3; s++) {
+		fprintf(stdout, "%-14s %10d %12.3E %12.3E %12.3E ",
+			names[s], iterations[s], residuals[s], times[s],
+			times[s] / (iterations[s] > 0 ? iterations[s] : 1));
+		// A diverged run has no meaningful time to compare against
+		if (isfinite(residuals[0]) && isfinite(residuals[s]))
+			fprintf(stdout, "%9.1fx\n", times[0] / times[s]);
+		else
+			fprintf(stdout, "%10s\n", "n/a");
+	}
+
+	free(a); free(b); free(d); free(x);
+	return EXIT_SUCCESS;
+}
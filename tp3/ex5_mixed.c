@@ -0,0 +1,243 @@
+// Mixed-precision Jacobi for the ex5.c system
+//
+// The double path is the ex5.c solver. The mixed path keeps a float copy of
+// A for the sweeps (half the matrix traffic) and wraps them in iterative
+// refinement carried out in double:
+//   r = b - A x            (double, one pass over the double matrix)
+//   solve A e = r          (float Jacobi sweeps on the float matrix)
+//   x = x + e              (double)
+// until max|e| / n <= DBL_EPSILON, the same criterion ex5.c applies to
+// max|x_courant - x| / n.
+//
+// Both paths use A stored row-major as M[i][j] = a[j*n+i], which is the
+// matrix ex5.c actually iterates with.
+//
+// Compile: gcc -O2 -fopenmp ex5_mixed.c -o ex5_mixed -lm
+// Run:     ./ex5_mixed [--n N] [--diag D] [--inner-tol T] [--inner-max K]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <omp.h>
+
+#ifndef VAL_N
+#define VAL_N 120
+#endif
+#ifndef VAL_D
+#define VAL_D 80
+#endif
+
+void random_number(double* array, int size) {
+	for (int i = 0; i < size; i++) {
+		array[i] = (double)rand() / (double)(RAND_MAX - 1);
+	}
+}
+
+// Pure double Jacobi, as in ex5.c. Returns the iteration count.
+int jacobi_double(const double *m, const double *b, double *x, int n, double *norme) {
+	double *x_courant = malloc(n * sizeof(double));
+	int iteration = 0;
+
+	for (int i = 0; i < n; i++) x[i] = 1.0;
+
+	while (1) {
+		iteration++;
+
+		double absmax = 0;
+		#pragma omp parallel for reduction(max:absmax) schedule(static)
+		for (int i = 0; i < n; i++) {
+			double s = 0;
+			#pragma omp simd reduction(+:s)
+			for (int j = 0; j < n; j++)
+				s += m[i * n + j] * x[j];
+			x_courant[i] = x[i] + (b[i] - s) / m[i * n + i];
+			double curr = fabs(x[i] - x_courant[i]);
+			if (curr > absmax) absmax = curr;
+		}
+		*norme = absmax / n;
+
+		if ((*norme <= DBL_EPSILON) || (iteration >= n)) break;
+
+		memcpy(x, x_courant, n * sizeof(double));
+	}
+
+	memcpy(x, x_courant, n * sizeof(double));
+	free(x_courant);
+	return iteration;
+}
+
+// Float Jacobi sweeps for m e = r starting from e = 0. Stops when the update
+// falls below inner_tol relative to |e|, or after inner_max sweeps.
+int jacobi_float(const float *mf, const float *r, float *e, float *e_courant,
+		int n, float inner_tol, int inner_max) {
+	int sweeps = 0;
+
+	for (int i = 0; i < n; i++) e[i] = 0.0f;
+
+	while (sweeps < inner_max) {
+		sweeps++;
+
+		float absmax = 0, emax = 0;
+		#pragma omp parallel for reduction(max:absmax, emax) schedule(static)
+		for (int i = 0; i < n; i++) {
+			float s = 0;
+			#pragma omp simd reduction(+:s)
+			for (int j = 0; j < n; j++)
+				s += mf[i * n + j] * e[j];
+			e_courant[i] = e[i] + (r[i] - s) / mf[i * n + i];
+			float curr = fabsf(e[i] - e_courant[i]);
+			if (curr > absmax) absmax = curr;
+			if (fabsf(e_courant[i]) > emax) emax = fabsf(e_courant[i]);
+		}
+
+		float *tmp = e; e = e_courant; e_courant = tmp;
+		if (absmax <= inner_tol * emax) break;
+	}
+
+	// The caller's e must hold the last iterate
+	if (sweeps % 2 == 1) memcpy(e_courant, e, n * sizeof(float));
+	return sweeps;
+}
+
+// Returns the number of refinement steps; *sweeps counts the float sweeps.
+int jacobi_mixed(const double *m, const float *mf, const double *b, double *x,
+		int n, float inner_tol, int inner_max, double *norme, int *sweeps) {
+	float *r = malloc(n * sizeof(float));
+	float *e = malloc(n * sizeof(float));
+	float *e_courant = malloc(n * sizeof(float));
+	int iteration = 0;
+
+	*sweeps = 0;
+	for (int i = 0; i < n; i++) x[i] = 1.0;
+
+	while (1) {
+		iteration++;
+
+		// Residual in double; only the correction equation is solved in float
+		#pragma omp parallel for schedule(static)
+		for (int i = 0; i < n; i++) {
+			double s = 0;
+			#pragma omp simd reduction(+:s)
+			for (int j = 0; j < n; j++)
+				s += m[i * n + j] * x[j];
+			r[i] = (float)(b[i] - s);
+		}
+
+		*sweeps += jacobi_float(mf, r, e, e_courant, n, inner_tol, inner_max);
+
+		double absmax = 0;
+		for (int i = 0; i < n; i++) {
+			x[i] += e[i];
+			if (fabs((double)e[i]) > absmax) absmax = fabs((double)e[i]);
+		}
+		*norme = absmax / n;
+
+		if ((*norme <= DBL_EPSILON) || (iteration >= n)) break;
+	}
+
+	free(r); free(e); free(e_courant);
+	return iteration;
+}
+
+double residual(const double *m, const double *b, const double *x, int n) {
+	double rmax = 0;
+	#pragma omp parallel for reduction(max:rmax) schedule(static)
+	for (int i = 0; i < n; i++) {
+		double s = 0;
+		for (int j = 0; j < n; j++)
+			s += m[i * n + j] * x[j];
+		if (fabs(b[i] - s) > rmax) rmax = fabs(b[i] - s);
+	}
+	return rmax;
+}
+
+int main(int argc, char *argv[]) {
+	int n = VAL_N, diag = VAL_D;
+	float inner_tol = 1e-4f;
+	int inner_max = 50;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) n = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--diag") == 0 && i + 1 < argc) diag = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--inner-tol") == 0 && i + 1 < argc) inner_tol = atof(argv[++i]);
+		else if (strcmp(argv[i], "--inner-max") == 0 && i + 1 < argc) inner_max = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [--n N] [--diag D] [--inner-tol T] [--inner-max K]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (n <= 0 || inner_max <= 0) {
+		fprintf(stderr, "n and inner-max must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	double *a = (double*)malloc((size_t)n * n * sizeof(double));
+	double *m = (double*)malloc((size_t)n * n * sizeof(double));
+	float *mf = (float*)malloc((size_t)n * n * sizeof(float));
+	double *b = (double*)malloc(n * sizeof(double));
+	double *x_double = (double*)malloc(n * sizeof(double));
+	double *x_mixed = (double*)malloc(n * sizeof(double));
+
+	if (!a || !m || !mf || !b || !x_double || !x_mixed) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	srand(421);
+	random_number(a, n * n);
+	random_number(b, n);
+
+	for (int i = 0; i < n; i++) {
+		a[i * n + i] += diag;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			m[i * n + j] = a[j * n + i];
+			mf[i * n + j] = (float)a[j * n + i];
+		}
+	}
+	free(a);
+
+	double norme_double, norme_mixed;
+	int sweeps;
+
+	double t0 = omp_get_wtime();
+	int it_double = jacobi_double(m, b, x_double, n, &norme_double);
+	double t_double = omp_get_wtime() - t0;
+
+	t0 = omp_get_wtime();
+	int it_mixed = jacobi_mixed(m, mf, b, x_mixed, n, inner_tol, inner_max,
+		&norme_mixed, &sweeps);
+	double t_mixed = omp_get_wtime() - t0;
+
+	double diff = 0;
+	for (int i = 0; i < n; i++)
+		if (fabs(x_mixed[i] - x_double[i]) > diff) diff = fabs(x_mixed[i] - x_double[i]);
+
+	fprintf(stdout, "\n\nSystem size            : %5d\n"
+		"Threads                : %d\n"
+		"Matrix bytes (double)  : %10.3E MB\n"
+		"Matrix bytes (float)   : %10.3E MB\n\n",
+		n, omp_get_max_threads(),
+		(double)n * n * sizeof(double) / 1e6, (double)n * n * sizeof(float) / 1e6);
+
+	fprintf(stdout, "%-8s %10s %10s %12s %12s %12s\n",
+		"Path", "Outer it", "Sweeps", "Norme", "Residual", "Time (s)");
+	fprintf(stdout, "%-8s %10d %10d %12.3E %12.3E %12.3E\n",
+		"double", it_double, it_double, norme_double,
+		residual(m, b, x_double, n), t_double);
+	fprintf(stdout, "%-8s %10d %10d %12.3E %12.3E %12.3E\n",
+		"mixed", it_mixed, sweeps, norme_mixed,
+		residual(m, b, x_mixed, n), t_mixed);
+
+	fprintf(stdout, "\nmax |x_mixed - x_double| : %10.3E\n"
+		"Speedup (mixed)          : %.2fx\n",
+		diff, t_double / t_mixed);
+
+	free(m); free(mf); free(b); free(x_double); free(x_mixed);
+	return EXIT_SUCCESS;
+}
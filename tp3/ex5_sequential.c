@@ -18,12 +18,20 @@ void random_number(double* array, int size) {
 	}
 }
 
-int main() {
+// Usage: ./ex5_sequential [n [diag]]
+int main(int argc, char *argv[]) {
 	int n = VAL_N, diag = VAL_D;
 	int i, j, iteration = 0;
 	double norme;
 
-	double *a = (double*)malloc(n * n * sizeof(double));
+	if (argc >= 2) n = atoi(argv[1]);
+	if (argc >= 3) diag = atoi(argv[2]);
+	if (n <= 0) {
+		fprintf(stderr, "System size must be positive\n");
+		exit(EXIT_FAILURE);
+	}
+
+	double *a = (double*)malloc((size_t)n * n * sizeof(double));
 	double *x = (double*)malloc(n * sizeof(double));
 	double *x_courant = (double*)malloc(n * sizeof(double));
 	double *b = (double*)malloc(n * sizeof(double));
@@ -0,0 +1,515 @@
+// Sparse Jacobi solver (CSR, ELLPACK and SELL-C-sigma storage)
+//
+// Same iteration and stopping rule as ex5.c, but A is stored sparse so that
+// memory and time per sweep scale with nnz instead of n*n.
+//   x_courant = x + (b - A x) / diag(A)
+//
+// The matrix is either generated (diagonally dominant, VAL_K off-diagonal
+// entries per row on average) or read from a Matrix Market file.
+//
+// Compile: gcc -O2 -fopenmp ex5_sparse.c -o ex5_sparse -lm
+// Run:     ./ex5_sparse [--n N] [--diag D] [--k K] [--format csr|ell|sell]
+//                       [--C C] [--sigma S] [--mtx file.mtx] [--maxit M]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <sys/time.h>
+#include <omp.h>
+
+#ifndef VAL_N
+#define VAL_N 100000
+#endif
+#ifndef VAL_D
+#define VAL_D 80
+#endif
+#ifndef VAL_K
+#define VAL_K 16
+#endif
+#ifndef SELL_C
+#define SELL_C 8
+#endif
+#ifndef SELL_SIGMA
+#define SELL_SIGMA 256
+#endif
+
+enum { FMT_CSR, FMT_ELL, FMT_SELL };
+
+typedef struct {
+	int n;
+	long nnz;
+	long *row_ptr;   // n + 1
+	int *col;        // nnz
+	double *val;     // nnz
+} csr_t;
+
+// SELL-C-sigma: rows sorted by length inside windows of sigma rows, then cut
+// into chunks of C rows stored column-major and padded to the longest row of
+// the chunk. ELLPACK is the special case sigma = 1 with every chunk padded to
+// the global maximum row length.
+typedef struct {
+	int n, C, nchunks;
+	long nnz_stored;
+	long *chunk_ptr; // nchunks + 1, offsets into col/val
+	int *chunk_len;  // width of each chunk
+	int *perm;       // sorted position -> original row
+	int *col;
+	double *val;
+} sell_t;
+
+void random_number(double* array, int size) {
+	for (int i = 0; i < size; i++) {
+		array[i] = (double)rand() / (double)(RAND_MAX - 1);
+	}
+}
+
+static void *xmalloc(size_t bytes) {
+	void *p = malloc(bytes ? bytes : 1);
+	if (!p) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+static int cmp_int(const void *a, const void *b) {
+	int x = *(const int*)a, y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+// Diagonally dominant random matrix: row i holds its diagonal plus between
+// 0 and 2*k distinct off-diagonal columns, so row lengths vary and a plain
+// row-count split of the SpMV would be unbalanced.
+void generate_csr(csr_t *A, int n, int diag, int k) {
+	int *len = xmalloc(n * sizeof(int));
+	int *tmp = xmalloc((2 * k + 1) * sizeof(int));
+	long nnz = 0;
+
+	srand(421);
+	for (int i = 0; i < n; i++) {
+		len[i] = 1 + (n > 1 ? rand() % (2 * k + 1) : 0);
+		if (len[i] > n) len[i] = n;
+		nnz += len[i];
+	}
+
+	A->n = n;
+	A->nnz = nnz;
+	A->row_ptr = xmalloc((n + 1) * sizeof(long));
+	A->col = xmalloc(nnz * sizeof(int));
+	A->val = xmalloc(nnz * sizeof(double));
+
+	A->row_ptr[0] = 0;
+	for (int i = 0; i < n; i++) {
+		long p = A->row_ptr[i];
+		int m = 0;
+		tmp[m++] = i;
+		while (m < len[i]) {
+			int c = rand() % n, dup = 0;
+			for (int q = 0; q < m; q++)
+				if (tmp[q] == c) { dup = 1; break; }
+			if (!dup) tmp[m++] = c;
+		}
+		qsort(tmp, m, sizeof(int), cmp_int);
+		for (int q = 0; q < m; q++) {
+			A->col[p + q] = tmp[q];
+			A->val[p + q] = (double)rand() / (double)(RAND_MAX - 1);
+			if (tmp[q] == i) A->val[p + q] += diag;
+		}
+		A->row_ptr[i + 1] = p + m;
+	}
+	free(len); free(tmp);
+}
+
+// Matrix Market coordinate reader (real/integer/pattern, general/symmetric).
+int read_mtx(const char *path, csr_t *A) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Cannot open %s\n", path);
+		return -1;
+	}
+
+	char line[1024], object[64], format[64], field[64], symmetry[64];
+	if (!fgets(line, sizeof(line), f) ||
+		sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s",
+			object, format, field, symmetry) != 4 ||
+		strcmp(format, "coordinate") != 0 || strcmp(field, "complex") == 0) {
+		fprintf(stderr, "%s: only real/integer/pattern coordinate matrices are supported\n", path);
+		fclose(f);
+		return -1;
+	}
+	int pattern = strcmp(field, "pattern") == 0;
+	int symmetric = strcmp(symmetry, "general") != 0;
+
+	do {
+		if (!fgets(line, sizeof(line), f)) {
+			fclose(f);
+			return -1;
+		}
+	} while (line[0] == '%');
+
+	int rows, cols;
+	long entries;
+	if (sscanf(line, "%d %d %ld", &rows, &cols, &entries) != 3 || rows != cols) {
+		fprintf(stderr, "%s: expected a square matrix\n", path);
+		fclose(f);
+		return -1;
+	}
+	if (rows < 1 || entries < 0 || entries > (long)rows * cols) {
+		fprintf(stderr, "%s: bad header (%d x %d, %ld entries)\n", path, rows, cols, entries);
+		fclose(f);
+		return -1;
+	}
+
+	long cap = symmetric ? 2 * entries : entries, nnz = 0;
+	int *ci = xmalloc(cap * sizeof(int));
+	int *cj = xmalloc(cap * sizeof(int));
+	double *cv = xmalloc(cap * sizeof(double));
+
+	for (long e = 0; e < entries; e++) {
+		int i, j;
+		double v = 1.0;
+		if (!fgets(line, sizeof(line), f) ||
+			sscanf(line, pattern ? "%d %d" : "%d %d %lf", &i, &j, &v) < 2) {
+			fprintf(stderr, "%s: truncated at entry %ld\n", path, e);
+			free(ci); free(cj); free(cv); fclose(f);
+			return -1;
+		}
+		if (i < 1 || i > rows || j < 1 || j > cols) {
+			fprintf(stderr, "%s: entry %ld (%d, %d) outside %d x %d\n",
+				path, e, i, j, rows, cols);
+			free(ci); free(cj); free(cv); fclose(f);
+			return -1;
+		}
+		ci[nnz] = i - 1; cj[nnz] = j - 1; cv[nnz] = v; nnz++;
+		if (symmetric && i != j) {
+			ci[nnz] = j - 1; cj[nnz] = i - 1;
+			cv[nnz] = strcmp(symmetry, "skew-symmetric") == 0 ? -v : v;
+			nnz++;
+		}
+	}
+	fclose(f);
+
+	A->n = rows;
+	A->nnz = nnz;
+	A->row_ptr = calloc(rows + 1, sizeof(long));
+	A->col = xmalloc(nnz * sizeof(int));
+	A->val = xmalloc(nnz * sizeof(double));
+	if (!A->row_ptr) {
+		fprintf(stderr, "Memory allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (long e = 0; e < nnz; e++) A->row_ptr[ci[e] + 1]++;
+	for (int i = 0; i < rows; i++) A->row_ptr[i + 1] += A->row_ptr[i];
+	long *next = xmalloc(rows * sizeof(long));
+	memcpy(next, A->row_ptr, rows * sizeof(long));
+	for (long e = 0; e < nnz; e++) {
+		long p = next[ci[e]]++;
+		A->col[p] = cj[e];
+		A->val[p] = cv[e];
+	}
+	free(next); free(ci); free(cj); free(cv);
+	return 0;
+}
+
+// Returns -1 if some row has no (or a zero) diagonal entry.
+int extract_diag(const csr_t *A, double *d) {
+	for (int i = 0; i < A->n; i++) {
+		d[i] = 0.0;
+		for (long p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++)
+			if (A->col[p] == i) d[i] += A->val[p];
+		if (d[i] == 0.0) return -1;
+	}
+	return 0;
+}
+
+// Split [0, nitems) into nparts ranges holding about the same number of
+// nonzeros, given the prefix sums ptr[0..nitems].
+void balance(const long *ptr, int nitems, int nparts, int *bounds) {
+	long total = ptr[nitems];
+	bounds[0] = 0;
+	for (int t = 1; t < nparts; t++) {
+		long target = total * t / nparts;
+		int lo = bounds[t - 1], hi = nitems;
+		while (lo < hi) {
+			int mid = lo + (hi - lo) / 2;
+			if (ptr[mid] < target) lo = mid + 1;
+			else hi = mid;
+		}
+		bounds[t] = lo;
+	}
+	bounds[nparts] = nitems;
+}
+
+static const int *sort_len;
+
+static int cmp_len_desc(const void *a, const void *b) {
+	int x = sort_len[*(const int*)a], y = sort_len[*(const int*)b];
+	return (y > x) - (y < x);
+}
+
+void build_sell(const csr_t *A, int C, int sigma, int ell, sell_t *S) {
+	int n = A->n;
+	int *len = xmalloc(n * sizeof(int));
+	int maxlen = 0;
+	for (int i = 0; i < n; i++) {
+		len[i] = (int)(A->row_ptr[i + 1] - A->row_ptr[i]);
+		if (len[i] > maxlen) maxlen = len[i];
+	}
+
+	S->n = n;
+	S->C = C;
+	S->nchunks = (n + C - 1) / C;
+	S->perm = xmalloc(n * sizeof(int));
+	for (int i = 0; i < n; i++) S->perm[i] = i;
+
+	sort_len = len;
+	if (!ell && sigma > 1)
+		for (int w = 0; w < n; w += sigma)
+			qsort(S->perm + w, (w + sigma < n ? sigma : n - w), sizeof(int), cmp_len_desc);
+
+	S->chunk_ptr = xmalloc((S->nchunks + 1) * sizeof(long));
+	S->chunk_len = xmalloc(S->nchunks * sizeof(int));
+	S->chunk_ptr[0] = 0;
+	for (int c = 0; c < S->nchunks; c++) {
+		int width = 0;
+		if (ell) {
+			width = maxlen;
+		} else {
+			for (int r = c * C; r < (c + 1) * C && r < n; r++)
+				if (len[S->perm[r]] > width) width = len[S->perm[r]];
+		}
+		S->chunk_len[c] = width;
+		S->chunk_ptr[c + 1] = S->chunk_ptr[c] + (long)width * C;
+	}
+	S->nnz_stored = S->chunk_ptr[S->nchunks];
+	S->col = xmalloc(S->nnz_stored * sizeof(int));
+	S->val = xmalloc(S->nnz_stored * sizeof(double));
+
+	// Padding points at the row itself with a zero value, so it stays in cache.
+	#pragma omp parallel for schedule(static)
+	for (int c = 0; c < S->nchunks; c++) {
+		for (int r = 0; r < C; r++) {
+			int pos = c * C + r;
+			int row = pos < n ? S->perm[pos] : (n - 1);
+			for (int j = 0; j < S->chunk_len[c]; j++) {
+				long dst = S->chunk_ptr[c] + (long)j * C + r;
+				if (pos < n && j < len[row]) {
+					S->col[dst] = A->col[A->row_ptr[row] + j];
+					S->val[dst] = A->val[A->row_ptr[row] + j];
+				} else {
+					S->col[dst] = row;
+					S->val[dst] = 0.0;
+				}
+			}
+		}
+	}
+	free(len);
+}
+
+// The sweeps and the first touch walk the nbins ranges of bounds with a
+// stride of the team size: with the full team thread t owns bin t, and a
+// smaller team (OMP_DYNAMIC, thread limits) still covers every bin.
+
+// First touch of x and x_courant by the thread that sweeps each row;
+// sell is NULL for CSR, where bins are row ranges.
+void first_touch(const sell_t *sell, const int *bounds, int nbins, int n,
+		double *x, double *x_courant) {
+	#pragma omp parallel
+	{
+		for (int bin = omp_get_thread_num(); bin < nbins; bin += omp_get_num_threads()) {
+			int lo = sell ? bounds[bin] * sell->C : bounds[bin];
+			int hi = sell ? bounds[bin + 1] * sell->C : bounds[bin + 1];
+			if (hi > n) hi = n;
+			for (int pos = lo; pos < hi; pos++) {
+				int i = sell ? sell->perm[pos] : pos;
+				x[i] = 1.0;
+				x_courant[i] = 0.0;
+			}
+		}
+	}
+}
+
+// One Jacobi sweep with CSR SpMV; returns max |x_courant - x|.
+double sweep_csr(const csr_t *A, const int *bounds, int nbins, const double *d,
+		const double *b, const double *x, double *x_courant) {
+	double absmax = 0;
+	#pragma omp parallel reduction(max:absmax)
+	{
+		for (int bin = omp_get_thread_num(); bin < nbins; bin += omp_get_num_threads()) {
+			for (int i = bounds[bin]; i < bounds[bin + 1]; i++) {
+				double s = 0;
+				for (long p = A->row_ptr[i]; p < A->row_ptr[i + 1]; p++)
+					s += A->val[p] * x[A->col[p]];
+				x_courant[i] = x[i] + (b[i] - s) / d[i];
+				double curr = fabs(x_courant[i] - x[i]);
+				if (curr > absmax) absmax = curr;
+			}
+		}
+	}
+	return absmax;
+}
+
+// Same sweep on SELL-C-sigma: the C rows of a chunk are processed together,
+// which gives unit-stride, vectorizable access to col/val. scratch holds C
+// partial sums per thread.
+double sweep_sell(const sell_t *S, const int *bounds, int nbins, const double *d,
+		const double *b, const double *x, double *x_courant, double *scratch) {
+	double absmax = 0;
+	int C = S->C;
+	#pragma omp parallel reduction(max:absmax)
+	{
+		int t = omp_get_thread_num();
+		double *s = scratch + (long)t * C;
+		for (int bin = t; bin < nbins; bin += omp_get_num_threads()) {
+			for (int c = bounds[bin]; c < bounds[bin + 1]; c++) {
+				for (int r = 0; r < C; r++) s[r] = 0;
+				for (int j = 0; j < S->chunk_len[c]; j++) {
+					long off = S->chunk_ptr[c] + (long)j * C;
+					#pragma omp simd
+					for (int r = 0; r < C; r++)
+						s[r] += S->val[off + r] * x[S->col[off + r]];
+				}
+				for (int r = 0; r < C && c * C + r < S->n; r++) {
+					int i = S->perm[c * C + r];
+					x_courant[i] = x[i] + (b[i] - s[r]) / d[i];
+					double curr = fabs(x_courant[i] - x[i]);
+					if (curr > absmax) absmax = curr;
+				}
+			}
+		}
+	}
+	return absmax;
+}
+
+int main(int argc, char *argv[]) {
+	int n = VAL_N, diag = VAL_D, k = VAL_K;
+	int C = SELL_C, sigma = SELL_SIGMA, format = FMT_CSR;
+	long maxit = -1;
+	const char *mtx = NULL;
+	int iteration = 0;
+	double norme;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--n") == 0 && i + 1 < argc) n = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--diag") == 0 && i + 1 < argc) diag = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc) k = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--C") == 0 && i + 1 < argc) C = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--sigma") == 0 && i + 1 < argc) sigma = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--maxit") == 0 && i + 1 < argc) maxit = atol(argv[++i]);
+		else if (strcmp(argv[i], "--mtx") == 0 && i + 1 < argc) mtx = argv[++i];
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "csr") == 0) format = FMT_CSR;
+			else if (strcmp(argv[i], "ell") == 0) format = FMT_ELL;
+			else if (strcmp(argv[i], "sell") == 0) format = FMT_SELL;
+			else {
+				fprintf(stderr, "Unknown format %s (csr, ell or sell)\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		} else {
+			fprintf(stderr, "Usage: %s [--n N] [--diag D] [--k K] [--format csr|ell|sell]"
+				" [--C C] [--sigma S] [--mtx file.mtx] [--maxit M]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (n <= 0 || k < 0 || C <= 0 || sigma <= 0) {
+		fprintf(stderr, "n, C and sigma must be positive, k non-negative\n");
+		return EXIT_FAILURE;
+	}
+
+	csr_t A;
+	if (mtx) {
+		if (read_mtx(mtx, &A) != 0) return EXIT_FAILURE;
+	} else {
+		generate_csr(&A, n, diag, k);
+	}
+	n = A.n;
+	if (maxit < 0) maxit = n;
+
+	double *d = xmalloc(n * sizeof(double));
+	double *x = xmalloc(n * sizeof(double));
+	double *x_courant = xmalloc(n * sizeof(double));
+	double *b = xmalloc(n * sizeof(double));
+
+	if (extract_diag(&A, d) != 0) {
+		fprintf(stderr, "Matrix has a zero diagonal entry, Jacobi is undefined\n");
+		return EXIT_FAILURE;
+	}
+
+	srand(421);
+	random_number(b, n);
+
+	int nthreads = omp_get_max_threads();
+	int *bounds = xmalloc((nthreads + 1) * sizeof(int));
+	sell_t S;
+	double *scratch = NULL;
+	size_t bytes;
+	long nnz = A.nnz;
+
+	if (format == FMT_CSR) {
+		balance(A.row_ptr, n, nthreads, bounds);
+		bytes = (n + 1) * sizeof(long) + A.nnz * (sizeof(int) + sizeof(double));
+	} else {
+		build_sell(&A, C, sigma, format == FMT_ELL, &S);
+		scratch = xmalloc((long)nthreads * C * sizeof(double));
+		balance(S.chunk_ptr, S.nchunks, nthreads, bounds);
+		bytes = (S.nchunks + 1) * sizeof(long) + S.nchunks * sizeof(int) +
+			n * sizeof(int) + S.nnz_stored * (sizeof(int) + sizeof(double));
+		free(A.row_ptr); free(A.col); free(A.val);
+	}
+
+	// First touch of the vectors with the same partition as the sweep
+	first_touch(format == FMT_CSR ? NULL : &S, bounds, nthreads, n, x, x_courant);
+
+	struct timeval t_elapsed_0, t_elapsed_1;
+	double t_elapsed;
+
+	gettimeofday(&t_elapsed_0, NULL);
+
+	while (1) {
+		iteration++;
+
+		double absmax = format == FMT_CSR
+			? sweep_csr(&A, bounds, nthreads, d, b, x, x_courant)
+			: sweep_sell(&S, bounds, nthreads, d, b, x, x_courant, scratch);
+		norme = absmax / n;
+
+		if ((norme <= DBL_EPSILON) || (iteration >= maxit)) break;
+
+		double *tmp = x; x = x_courant; x_courant = tmp;
+	}
+
+	gettimeofday(&t_elapsed_1, NULL);
+	t_elapsed = (t_elapsed_1.tv_sec - t_elapsed_0.tv_sec) +
+		(t_elapsed_1.tv_usec - t_elapsed_0.tv_usec) / 1e6;
+
+	const char *names[] = { "CSR", "ELLPACK", "SELL-C-sigma" };
+	long stored = format == FMT_CSR ? A.nnz : S.nnz_stored;
+	fprintf(stdout, "\n\nFormat                 : %s", names[format]);
+	if (format == FMT_SELL) fprintf(stdout, " (C=%d, sigma=%d)", C, sigma);
+	if (format == FMT_ELL) fprintf(stdout, " (C=%d)", C);
+	fprintf(stdout, "\nSystem size            : %5d\n"
+		"Nonzeros               : %ld\n"
+		"Stored entries         : %ld\n"
+		"Matrix memory          : %10.3E MB\n"
+		"Threads                : %d\n"
+		"Iterations             : %4d\n"
+		"Norme                  : %10.3E\n"
+		"Elapsed time           : %10.3E sec.\n"
+		"Time per iteration     : %10.3E sec.\n"
+		"GFLOP/s                : %10.3f\n",
+		n, nnz, stored, bytes / 1e6, nthreads, iteration, norme, t_elapsed,
+		t_elapsed / iteration, 2.0 * nnz * iteration / t_elapsed / 1e9);
+
+	if (format == FMT_CSR) {
+		free(A.row_ptr); free(A.col); free(A.val);
+	} else {
+		free(S.chunk_ptr); free(S.chunk_len); free(S.perm); free(S.col); free(S.val);
+		free(scratch);
+	}
+	free(d); free(x); free(x_courant); free(b); free(bounds);
+	return EXIT_SUCCESS;
+}
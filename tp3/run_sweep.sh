@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+# Thread/affinity sweep for the Jacobi solver (ex5.c)
+# Usage: bash run_sweep.sh [n] [diag]
+#
+# Each run of "ex5 --sweep" covers all thread counts and proc_bind policies
+# in one process. OMP_PLACES is only read at runtime start-up, so it is the
+# one parameter that still needs a separate run.
+set -euo pipefail
+
+N=${1:-2000}
+DIAG=${2:-1500}
+
+gcc -O2 -fopenmp ex5.c -o ex5 -lm
+
+echo "places,threads,bind,iterations,time_per_iter,speedup,efficiency" > benchmark_sweep_ex5.csv
+for PLACES in threads cores sockets; do
+    echo "Running: n=$N diag=$DIAG OMP_PLACES=$PLACES"
+    OMP_PLACES=$PLACES ./ex5 "$N" "$DIAG" --sweep | grep -v -e '^#' -e '^threads' | sed "s/^/$PLACES,/" >> benchmark_sweep_ex5.csv
+done
+
+echo ""
+echo "Results saved to benchmark_sweep_ex5.csv"
@@ -8,6 +8,10 @@
  *
  * Key challenge: Section 3 depends on the result of Section 1 (the sum/mean).
  * We use a barrier between the sum/max computation and the stddev computation.
+ *
+ * A third version computes sum, min, max, mean and variance in a single pass
+ * with all threads: each thread reduces cache-sized blocks with SIMD loops,
+ * and the partial (count, mean, M2) states are merged with Chan's formula.
  */
 
 #include <stdio.h>
@@ -16,6 +20,95 @@
 #include <omp.h>
 
 #define N 1000000
+#define BLOCK 2048   /* doubles per block: 16 KB, stays in L1 for the 2nd loop */
+
+/* Mergeable partial statistics */
+typedef struct {
+    long   n;
+    double sum;
+    double mean;
+    double m2;      /* sum of squared deviations from mean */
+    double min;
+    double max;
+    char   pad[16]; /* one state per 64-byte cache line */
+} Stats;
+
+static void stats_init(Stats *s) {
+    s->n = 0;
+    s->sum = s->mean = s->m2 = 0.0;
+    s->min = INFINITY;
+    s->max = -INFINITY;
+}
+
+/* Chan et al. parallel merge of two partial states: a <- a U b */
+static void stats_merge(Stats *a, const Stats *b) {
+    if (b->n == 0) return;
+    if (a->n == 0) { *a = *b; return; }
+    long   n     = a->n + b->n;
+    double delta = b->mean - a->mean;
+    a->mean += delta * b->n / n;
+    a->m2   += b->m2 + delta * delta * ((double)a->n * b->n / n);
+    a->sum  += b->sum;
+    a->n     = n;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+}
+
+/* One block: vectorized sum/min/max, then M2 around the block mean while
+ * the block is still in L1, so main memory is only read once. */
+static void stats_block(Stats *s, const double *x, int len) {
+    double bsum = 0.0, bmin = INFINITY, bmax = -INFINITY, bm2 = 0.0;
+    #pragma omp simd reduction(+:bsum) reduction(min:bmin) reduction(max:bmax)
+    for (int i = 0; i < len; i++) {
+        bsum += x[i];
+        bmin = x[i] < bmin ? x[i] : bmin;
+        bmax = x[i] > bmax ? x[i] : bmax;
+    }
+    double bmean = bsum / len;
+    #pragma omp simd reduction(+:bm2)
+    for (int i = 0; i < len; i++)
+        bm2 += (x[i] - bmean) * (x[i] - bmean);
+
+    Stats b = { .n = len, .sum = bsum, .mean = bmean, .m2 = bm2,
+                .min = bmin, .max = bmax };
+    stats_merge(s, &b);
+}
+
+/* Single pass over A with all threads */
+static Stats stats_fused(const double *A, long n) {
+    int nthreads = omp_get_max_threads();   /* upper bound on the team size */
+    Stats *partial = aligned_alloc(64, nthreads * sizeof(Stats));
+    if (partial == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    long nblocks = (n + BLOCK - 1) / BLOCK;
+    int team = 0;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        team = omp_get_num_threads();
+
+        Stats local;
+        stats_init(&local);
+        #pragma omp for schedule(static)
+        for (long b = 0; b < nblocks; b++) {
+            long start = b * BLOCK;
+            int  len   = (int)(start + BLOCK <= n ? BLOCK : n - start);
+            stats_block(&local, A + start, len);
+        }
+        partial[omp_get_thread_num()] = local;
+    }
+
+    /* Merge in thread order so the result does not depend on timing */
+    Stats total;
+    stats_init(&total);
+    for (int t = 0; t < team; t++)
+        stats_merge(&total, &partial[t]);
+    free(partial);
+    return total;
+}
 
 int main() {
     double *A = malloc(N * sizeof(double));
@@ -39,9 +132,11 @@ int main() {
     
     double seq_sum = 0.0;
     double seq_max = A[0];
+    double seq_min = A[0];
     for (int i = 0; i < N; i++) {
         seq_sum += A[i];
         if (A[i] > seq_max) seq_max = A[i];
+        if (A[i] < seq_min) seq_min = A[i];
     }
     double seq_mean = seq_sum / N;
     double seq_stddev = 0.0;
@@ -53,6 +148,7 @@ int main() {
 
     printf("=== Sequential Results ===\n");
     printf("Sum     = %f\n", seq_sum);
+    printf("Min     = %f\n", seq_min);
     printf("Max     = %f\n", seq_max);
     printf("Std Dev = %f\n", seq_stddev);
     printf("Time    = %f seconds\n\n", t_seq_end - t_seq_start);
@@ -129,15 +225,38 @@ int main() {
     printf("Std Dev = %f\n", stddev);
     printf("Time    = %f seconds\n\n", t_par_end - t_par_start);
 
-    double speedup = (t_seq_end - t_seq_start) / (t_par_end - t_par_start);
-    printf("Speedup = %.2fx\n", speedup);
+    /* ============ Parallel Version (Fused single pass) ============ */
+    double t_fused_start = omp_get_wtime();
+    Stats st = stats_fused(A, N);
+    double fused_stddev = sqrt(st.m2 / st.n);
+    double t_fused_end = omp_get_wtime();
+
+    printf("=== Parallel Results (Fused single pass) ===\n");
+    printf("Sum     = %f\n", st.sum);
+    printf("Min     = %f\n", st.min);
+    printf("Max     = %f\n", st.max);
+    printf("Mean    = %f\n", st.mean);
+    printf("Var     = %f\n", st.m2 / st.n);
+    printf("Std Dev = %f\n", fused_stddev);
+    printf("Time    = %f seconds\n\n", t_fused_end - t_fused_start);
+
+    double t_seq = t_seq_end - t_seq_start;
+    double t_par = t_par_end - t_par_start;
+    double t_fused = t_fused_end - t_fused_start;
     printf("Threads = %d\n", omp_get_max_threads());
+    printf("Speedup (sections)          = %.2fx\n", t_seq / t_par);
+    printf("Speedup (fused)             = %.2fx\n", t_seq / t_fused);
+    printf("Speedup (fused vs sections) = %.2fx\n", t_par / t_fused);
 
     /* Verify correctness */
     printf("\n=== Verification ===\n");
     printf("Sum diff     = %e\n", fabs(sum - seq_sum));
     printf("Max diff     = %e\n", fabs(max_val - seq_max));
     printf("Stddev diff  = %e\n", fabs(stddev - seq_stddev));
+    printf("Fused sum diff     = %e\n", fabs(st.sum - seq_sum));
+    printf("Fused min diff     = %e\n", fabs(st.min - seq_min));
+    printf("Fused max diff     = %e\n", fabs(st.max - seq_max));
+    printf("Fused stddev diff  = %e\n", fabs(fused_stddev - seq_stddev));
 
     free(A);
     return 0;
@@ -0,0 +1,268 @@
+/**
+ * TP4 - Exercise 1 (streaming): Statistics over a file larger than memory
+ *
+ * Same summary as ex1_sections.c (sum, min, max, mean, std dev) but the data
+ * is read from a binary file of doubles instead of one malloc'd array.
+ *
+ * The file is cut into chunks handed out dynamically to the threads. Each
+ * chunk is reduced in one pass into a mergeable (count, mean, M2, min, max)
+ * state, so the two-pass stddev formula and its second read of the file are
+ * not needed. Chunk states are merged in file order with Chan's formula.
+ *
+ * I/O overlaps compute across threads: while a thread reduces its chunk it
+ * has already asked the kernel to read ahead the chunk it will likely get
+ * next (madvise/posix_fadvise WILLNEED), and other threads are blocked in
+ * their own reads. Finished chunks are dropped from the page cache.
+ *
+ * Usage:
+ *   ./ex1_stream --generate <file> <count>     write <count> random doubles
+ *   ./ex1_stream --mmap  <file> [--chunk MB]   stream with mmap
+ *   ./ex1_stream --pread <file> [--chunk MB]   stream with pread
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#define BLOCK 2048   /* doubles per in-cache block */
+
+/* Mergeable partial statistics */
+typedef struct {
+    long   n;
+    double sum;
+    double mean;
+    double m2;      /* sum of squared deviations from mean */
+    double min;
+    double max;
+    char   pad[16]; /* one state per 64-byte cache line */
+} Stats;
+
+static void stats_init(Stats *s) {
+    s->n = 0;
+    s->sum = s->mean = s->m2 = 0.0;
+    s->min = INFINITY;
+    s->max = -INFINITY;
+}
+
+/* Chan et al. parallel merge of two partial states: a <- a U b */
+static void stats_merge(Stats *a, const Stats *b) {
+    if (b->n == 0) return;
+    if (a->n == 0) { *a = *b; return; }
+    long   n     = a->n + b->n;
+    double delta = b->mean - a->mean;
+    a->mean += delta * b->n / n;
+    a->m2   += b->m2 + delta * delta * ((double)a->n * b->n / n);
+    a->sum  += b->sum;
+    a->n     = n;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+}
+
+/* Reduce x[0..len) block by block into s */
+static void stats_chunk(Stats *s, const double *x, long len) {
+    for (long start = 0; start < len; start += BLOCK) {
+        int blen = (int)(start + BLOCK <= len ? BLOCK : len - start);
+        const double *p = x + start;
+        double bsum = 0.0, bmin = INFINITY, bmax = -INFINITY, bm2 = 0.0;
+        #pragma omp simd reduction(+:bsum) reduction(min:bmin) reduction(max:bmax)
+        for (int i = 0; i < blen; i++) {
+            bsum += p[i];
+            bmin = p[i] < bmin ? p[i] : bmin;
+            bmax = p[i] > bmax ? p[i] : bmax;
+        }
+        double bmean = bsum / blen;
+        #pragma omp simd reduction(+:bm2)
+        for (int i = 0; i < blen; i++)
+            bm2 += (p[i] - bmean) * (p[i] - bmean);
+
+        Stats b = { .n = blen, .sum = bsum, .mean = bmean, .m2 = bm2,
+                    .min = bmin, .max = bmax };
+        stats_merge(s, &b);
+    }
+}
+
+/* Same values as ex1_sections.c: srand(0), rand()/RAND_MAX */
+static int generate(const char *path, long count) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    double *buf = malloc(BLOCK * 64 * sizeof(double));
+    if (buf == NULL) {
+        printf("Memory allocation failed\n");
+        fclose(f);
+        return 1;
+    }
+    srand(0);
+    for (long done = 0; done < count; ) {
+        long len = count - done < BLOCK * 64 ? count - done : BLOCK * 64;
+        for (long i = 0; i < len; i++)
+            buf[i] = (double)rand() / RAND_MAX;
+        if (fwrite(buf, sizeof(double), len, f) != (size_t)len) {
+            perror(path);
+            free(buf);
+            fclose(f);
+            return 1;
+        }
+        done += len;
+    }
+    free(buf);
+    fclose(f);
+    printf("Wrote %ld doubles to %s\n", count, path);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = NULL, *path = NULL;
+    long chunk_mb = 64;
+
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0)
+        return generate(argv[2], atol(argv[3]));
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--mmap") == 0 || strcmp(argv[i], "--pread") == 0) && i+1 < argc) {
+            mode = argv[i] + 2;
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--chunk") == 0 && i+1 < argc) {
+            chunk_mb = atol(argv[++i]);
+        }
+    }
+    if (mode == NULL || chunk_mb <= 0) {
+        printf("Usage: %s --generate <file> <count>\n"
+               "       %s --mmap|--pread <file> [--chunk MB]\n", argv[0], argv[0]);
+        return 1;
+    }
+    int use_mmap = strcmp(mode, "mmap") == 0;
+
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        perror(path);
+        return 1;
+    }
+    long n = sb.st_size / sizeof(double);
+    if (n == 0) {
+        printf("%s holds no doubles\n", path);
+        return 1;
+    }
+
+    /* Chunks are whole pages so madvise ranges stay page aligned */
+    long page = sysconf(_SC_PAGESIZE);
+    long chunk = chunk_mb * 1024 * 1024 / sizeof(double);
+    chunk -= chunk % (page / sizeof(double));
+    if (chunk <= 0) chunk = page / sizeof(double);
+    long nchunks = (n + chunk - 1) / chunk;
+    int nthreads = omp_get_max_threads();
+
+    Stats *chunk_stats = malloc(nchunks * sizeof(Stats));
+    if (chunk_stats == NULL) {
+        printf("Memory allocation failed\n");
+        return 1;
+    }
+
+    double *map = NULL;
+    if (use_mmap) {
+        map = mmap(NULL, n * sizeof(double), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        madvise(map, n * sizeof(double), MADV_SEQUENTIAL);
+    } else {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    double t_start = omp_get_wtime();
+    int io_error = 0;
+
+    #pragma omp parallel
+    {
+        double *buf = use_mmap ? NULL : malloc(chunk * sizeof(double));
+        if (!use_mmap && buf == NULL) {
+            #pragma omp atomic write
+            io_error = 1;
+        }
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long c = 0; c < nchunks; c++) {
+            long start = c * chunk;
+            long len   = start + chunk <= n ? chunk : n - start;
+            long ahead = c + nthreads;   /* likely next chunk of this thread */
+            size_t bytes = len * sizeof(double);
+            off_t  off   = (off_t)start * sizeof(double);
+            const double *x;
+
+            stats_init(&chunk_stats[c]);
+            if (use_mmap) {
+                if (ahead < nchunks)
+                    madvise(map + ahead * chunk, chunk * sizeof(double), MADV_WILLNEED);
+                x = map + start;
+            } else {
+                if (buf == NULL) continue;
+                if (ahead < nchunks)
+                    posix_fadvise(fd, (off_t)ahead * chunk * sizeof(double),
+                                  chunk * sizeof(double), POSIX_FADV_WILLNEED);
+                size_t got = 0;
+                while (got < bytes) {
+                    ssize_t r = pread(fd, (char *)buf + got, bytes - got, off + got);
+                    if (r <= 0) break;
+                    got += r;
+                }
+                if (got < bytes) {
+                    #pragma omp atomic write
+                    io_error = 1;
+                    continue;
+                }
+                x = buf;
+            }
+
+            stats_chunk(&chunk_stats[c], x, len);
+
+            /* Data is read once: release it instead of evicting useful pages */
+            if (use_mmap)
+                madvise(map + start, bytes, MADV_DONTNEED);
+            else
+                posix_fadvise(fd, off, bytes, POSIX_FADV_DONTNEED);
+        }
+        free(buf);
+    }
+
+    Stats st;
+    stats_init(&st);
+    for (long c = 0; c < nchunks; c++)
+        stats_merge(&st, &chunk_stats[c]);
+
+    double t_end = omp_get_wtime();
+
+    if (use_mmap) munmap(map, n * sizeof(double));
+    close(fd);
+    free(chunk_stats);
+
+    if (io_error) {
+        printf("Read error on %s\n", path);
+        return 1;
+    }
+
+    double elapsed = t_end - t_start;
+    printf("=== Streaming Results (%s) ===\n", mode);
+    printf("Elements = %ld\n", st.n);
+    printf("Chunks   = %ld x %ld MB\n", nchunks, chunk_mb);
+    printf("Threads  = %d\n", nthreads);
+    printf("Sum      = %f\n", st.sum);
+    printf("Min      = %f\n", st.min);
+    printf("Max      = %f\n", st.max);
+    printf("Mean     = %f\n", st.mean);
+    printf("Std Dev  = %f\n", sqrt(st.m2 / st.n));
+    printf("Time     = %f seconds\n", elapsed);
+    printf("Rate     = %.1f MB/s\n", n * sizeof(double) / elapsed / 1e6);
+
+    return 0;
+}
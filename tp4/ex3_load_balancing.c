@@ -7,6 +7,15 @@
  *   Task B: moderate computation
  *   Task C: heavy computation
  * Measure execution time and optimize workload distribution.
+ *
+ * The optimized version builds a static plan from a cost model: measured cost
+ * per iteration, equal-cost pieces, LPT packing onto the threads.
+ *
+ * A task-based version splits every task's iteration space into chunks whose
+ * size comes from the measured cost per iteration, and runs them with
+ * taskloop, so the balance does not depend on the number of threads.
+ * Per-thread busy time and the imbalance ratio (max / mean busy time) are
+ * reported for every parallel version.
  */
 
 #include <stdio.h>
@@ -14,33 +23,222 @@
 #include <math.h>
 #include <omp.h>
 
-/* Light computation: N iterations */
-double task_light(int N) {
+#define CHUNKS_PER_THREAD 16   /* taskloop chunks per thread, all tasks combined */
+#define PIECES_PER_THREAD 4    /* plan pieces per thread, all tasks combined */
+#define PLAN_RUNS         5    /* runs executed with the same plan */
+#define REPLAN_IMBALANCE  1.10 /* rebuild the plan above this imbalance */
+
+/* Iterations [lo, hi) of each task */
+double light_range(long lo, long hi) {
     double x = 0.0;
-    for (int i = 0; i < N; i++) {
+    for (long i = lo; i < hi; i++) {
         x += sin(i * 0.001);
     }
     return x;
 }
 
-/* Moderate computation: 5*N iterations */
-double task_moderate(int N) {
+double moderate_range(long lo, long hi) {
     double x = 0.0;
-    for (int i = 0; i < 5*N; i++) {
+    for (long i = lo; i < hi; i++) {
         x += sqrt(i * 0.5) * cos(i * 0.001);
     }
     return x;
 }
 
-/* Heavy computation: 20*N iterations */
-double task_heavy(int N) {
+double heavy_range(long lo, long hi) {
     double x = 0.0;
-    for (int i = 0; i < 20*N; i++) {
+    for (long i = lo; i < hi; i++) {
         x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
     }
     return x;
 }
 
+/* Light computation: N iterations */
+double task_light(int N) {
+    return light_range(0, N);
+}
+
+/* Moderate computation: 5*N iterations */
+double task_moderate(int N) {
+    return moderate_range(0, 5L*N);
+}
+
+/* Heavy computation: 20*N iterations */
+double task_heavy(int N) {
+    return heavy_range(0, 20L*N);
+}
+
+/* Per-thread busy time, one cache line per thread */
+typedef struct {
+    double t;
+    char   pad[56];
+} Busy;
+
+static Busy *busy_alloc(int nthreads) {
+    Busy *b = aligned_alloc(64, nthreads * sizeof(Busy));
+    if (b == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int t = 0; t < nthreads; t++) b[t].t = 0.0;
+    return b;
+}
+
+/* Imbalance ratio max/mean of the busy times */
+static double busy_imbalance(const Busy *b, int nthreads) {
+    double max = 0.0, total = 0.0;
+    for (int t = 0; t < nthreads; t++) {
+        total += b[t].t;
+        if (b[t].t > max) max = b[t].t;
+    }
+    return total > 0.0 ? max / (total / nthreads) : 1.0;
+}
+
+/* Print busy times and return the imbalance ratio */
+static double busy_report(const char *name, const Busy *b, int nthreads) {
+    printf("[%s] busy:", name);
+    for (int t = 0; t < nthreads; t++)
+        printf(" T%d=%.3fs", t, b[t].t);
+    double imbalance = busy_imbalance(b, nthreads);
+    printf("  imbalance=%.2f\n", imbalance);
+    return imbalance;
+}
+
+/* Seconds per iteration of a task, measured on a short sample */
+static double calibrate(double (*range)(long, long), long total) {
+    long sample = total / 100 > 1000 ? total / 100 : (total < 1000 ? total : 1000);
+    long lo = (total - sample) / 2;     /* middle of the range: typical cost */
+    double t0 = omp_get_wtime();
+    volatile double sink = range(lo, lo + sample);
+    (void)sink;
+    return (omp_get_wtime() - t0) / sample;
+}
+
+/* ---------------- Cost-model partitioner ---------------- */
+
+typedef struct {
+    int    task;
+    long   lo, hi;
+    double cost;    /* estimated seconds */
+    double time;    /* measured seconds of the last run */
+    int    owner;   /* thread */
+} Piece;
+
+typedef struct {
+    int    nthreads;
+    int    npieces;
+    Piece *pieces;
+    double *load;   /* estimated seconds per thread */
+} Plan;
+
+static int piece_cmp_desc(const void *a, const void *b) {
+    double x = ((const Piece *)a)->cost, y = ((const Piece *)b)->cost;
+    return (y > x) - (y < x);
+}
+
+/*
+ * Cut each task into pieces of about total/(nthreads*PIECES_PER_THREAD)
+ * estimated seconds, then Longest Processing Time first: sort pieces by cost
+ * and give each to the currently least loaded thread.
+ */
+static void plan_build(Plan *p, const long *n_iters, const double *cost, int nthreads) {
+    double total = 0.0;
+    for (int k = 0; k < 3; k++) total += cost[k] * n_iters[k];
+    double target = total / (nthreads * PIECES_PER_THREAD);
+
+    long count[3];
+    p->npieces = 0;
+    for (int k = 0; k < 3; k++) {
+        count[k] = (long)ceil(cost[k] * n_iters[k] / target);
+        if (count[k] < 1) count[k] = 1;
+        if (count[k] > n_iters[k]) count[k] = n_iters[k];
+        p->npieces += count[k];
+    }
+
+    p->nthreads = nthreads;
+    p->pieces = malloc(p->npieces * sizeof(Piece));
+    p->load = calloc(nthreads, sizeof(double));
+    int np = 0;
+    for (int k = 0; k < 3; k++) {
+        for (long c = 0; c < count[k]; c++) {
+            Piece *q = &p->pieces[np++];
+            q->task = k;
+            q->lo = n_iters[k] * c / count[k];
+            q->hi = n_iters[k] * (c + 1) / count[k];
+            q->cost = cost[k] * (q->hi - q->lo);
+            q->time = 0.0;
+        }
+    }
+
+    qsort(p->pieces, p->npieces, sizeof(Piece), piece_cmp_desc);
+    for (int i = 0; i < p->npieces; i++) {
+        int best = 0;
+        for (int t = 1; t < nthreads; t++)
+            if (p->load[t] < p->load[best]) best = t;
+        p->pieces[i].owner = best;
+        p->load[best] += p->pieces[i].cost;
+    }
+}
+
+static double plan_predicted_imbalance(const Plan *p) {
+    double max = 0.0, total = 0.0;
+    for (int t = 0; t < p->nthreads; t++) {
+        total += p->load[t];
+        if (p->load[t] > max) max = p->load[t];
+    }
+    return max / (total / p->nthreads);
+}
+
+/* Each plan bin (the pieces of one owner) runs as one iteration of a static
+ * loop, so with the planned team size bin t runs on thread t, and a smaller
+ * team (thread limit, OMP_DYNAMIC) still runs every bin. Results are
+ * combined per task; *team receives the actual team size. */
+static void plan_execute(Plan *p, double (*ranges[3])(long, long),
+                         double *result, Busy *busy, int *team) {
+    double sums[3] = {0.0, 0.0, 0.0};
+    #pragma omp parallel num_threads(p->nthreads)
+    {
+        int tid = omp_get_thread_num();
+        #pragma omp single nowait
+        *team = omp_get_num_threads();
+
+        double local[3] = {0.0, 0.0, 0.0};
+        #pragma omp for schedule(static, 1)
+        for (int bin = 0; bin < p->nthreads; bin++) {
+            for (int i = 0; i < p->npieces; i++) {
+                Piece *q = &p->pieces[i];
+                if (q->owner != bin) continue;
+                double t0 = omp_get_wtime();
+                local[q->task] += ranges[q->task](q->lo, q->hi);
+                q->time = omp_get_wtime() - t0;
+                busy[tid].t += q->time;
+            }
+        }
+        #pragma omp critical
+        {
+            for (int k = 0; k < 3; k++) sums[k] += local[k];
+        }
+    }
+    for (int k = 0; k < 3; k++) result[k] = sums[k];
+}
+
+/* Cost per iteration of each task, from the piece times of the last run */
+static void plan_measured_cost(const Plan *p, double *cost) {
+    double time[3] = {0.0, 0.0, 0.0};
+    long iters[3] = {0, 0, 0};
+    for (int i = 0; i < p->npieces; i++) {
+        time[p->pieces[i].task]  += p->pieces[i].time;
+        iters[p->pieces[i].task] += p->pieces[i].hi - p->pieces[i].lo;
+    }
+    for (int k = 0; k < 3; k++)
+        if (iters[k] > 0 && time[k] > 0.0) cost[k] = time[k] / iters[k];
+}
+
+static void plan_free(Plan *p) {
+    free(p->pieces);
+    free(p->load);
+}
+
 int main() {
     int N_WORK = 1000000;
     double r1, r2, r3;
@@ -62,23 +260,36 @@ int main() {
     printf("=== Sequential Execution ===\n");
     printf("Time = %f seconds\n\n", t_seq);
 
+    int nthreads = omp_get_max_threads();   /* upper bound on the team sizes */
+    int team_naive = nthreads, team_opt = nthreads, team_task = nthreads;
+    Busy *busy_naive = busy_alloc(nthreads);
+    Busy *busy_opt   = busy_alloc(nthreads);
+    Busy *busy_task  = busy_alloc(nthreads);
+
     /* ============ Naive Parallel Sections (one task per section) ============ */
     double t_naive_start = omp_get_wtime();
     #pragma omp parallel sections
     {
         #pragma omp section
         {
+            team_naive = omp_get_num_threads();
+            double t0 = omp_get_wtime();
             r1 = task_light(N_WORK);
+            busy_naive[omp_get_thread_num()].t += omp_get_wtime() - t0;
             printf("[Naive] Task A (light) on thread %d\n", omp_get_thread_num());
         }
         #pragma omp section
         {
+            double t0 = omp_get_wtime();
             r2 = task_moderate(N_WORK);
+            busy_naive[omp_get_thread_num()].t += omp_get_wtime() - t0;
             printf("[Naive] Task B (moderate) on thread %d\n", omp_get_thread_num());
         }
         #pragma omp section
         {
+            double t0 = omp_get_wtime();
             r3 = task_heavy(N_WORK);
+            busy_naive[omp_get_thread_num()].t += omp_get_wtime() - t0;
             printf("[Naive] Task C (heavy) on thread %d\n", omp_get_thread_num());
         }
     }
@@ -86,82 +297,122 @@ int main() {
     double t_naive = t_naive_end - t_naive_start;
 
     printf("Time = %f seconds\n", t_naive);
+    double imb_naive = busy_report("Naive", busy_naive, team_naive);
     printf("Speedup = %.2fx\n\n", t_seq / t_naive);
 
-    /* ============ Optimized: Split heavy task into sub-tasks ============ */
+    /* ============ Optimized: cost-model plan (LPT) ============ */
     /*
-     * The naive approach is limited because the heavy task (20x) dominates.
-     * With 3 sections taking 1x, 5x, 20x the total is bounded by max(1,5,20) = 20x.
-     * Ideal: total_work/num_threads = 26x/3 ≈ 8.7x per thread.
-     *
-     * Optimization: Split the heavy task into multiple sub-sections so that
-     * work is more evenly distributed. We split heavy into 4 chunks,
-     * giving sections of: 1x, 5x, 5x, 5x, 5x, 5x (total 26x).
+     * The naive approach is limited because the heavy task dominates.
+     * Instead of a hand-computed split, each task's cost per iteration is
+     * measured on a short sample, the tasks are cut into pieces of equal
+     * estimated cost and the pieces are packed onto the threads with LPT.
+     * The plan is built once and reused for PLAN_RUNS runs; it is rebuilt
+     * from the measured piece times whenever a run's imbalance exceeds
+     * REPLAN_IMBALANCE, so it follows changes in task costs.
      */
-    double heavy_parts[4] = {0.0, 0.0, 0.0, 0.0};
-    int chunk = 20 * N_WORK / 4;
+    long n_iters[3] = { N_WORK, 5L*N_WORK, 20L*N_WORK };
+    double (*ranges[3])(long, long) = { light_range, moderate_range, heavy_range };
+    double cost[3], total_cost = 0.0;
+    for (int k = 0; k < 3; k++) {
+        cost[k] = calibrate(ranges[k], n_iters[k]);
+        total_cost += cost[k] * n_iters[k];
+    }
+    printf("Cost/iter (ns): light=%.1f moderate=%.1f heavy=%.1f\n",
+           cost[0] * 1e9, cost[1] * 1e9, cost[2] * 1e9);
 
-    double t_opt_start = omp_get_wtime();
-    #pragma omp parallel sections
-    {
-        #pragma omp section
-        {
-            /* Light task + part of heavy */
-            r1 = task_light(N_WORK);
-            double x = 0.0;
-            int start = 0, end = chunk;
-            for (int i = start; i < end; i++)
-                x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
-            heavy_parts[0] = x;
-            printf("[Optimized] Task A + Heavy[0] on thread %d\n", omp_get_thread_num());
-        }
-        #pragma omp section
-        {
-            /* Moderate task */
-            r2 = task_moderate(N_WORK);
-            printf("[Optimized] Task B on thread %d\n", omp_get_thread_num());
-        }
-        #pragma omp section
-        {
-            /* Heavy part 1+2 */
-            double x1 = 0.0, x2 = 0.0;
-            int start1 = chunk, end1 = 2*chunk;
-            int start2 = 2*chunk, end2 = 3*chunk;
-            for (int i = start1; i < end1; i++)
-                x1 += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
-            for (int i = start2; i < end2; i++)
-                x2 += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
-            heavy_parts[1] = x1;
-            heavy_parts[2] = x2;
-            printf("[Optimized] Heavy[1+2] on thread %d\n", omp_get_thread_num());
-        }
-        #pragma omp section
-        {
-            /* Heavy part 3 */
-            double x = 0.0;
-            int start = 3*chunk, end = 20*N_WORK;
-            for (int i = start; i < end; i++)
-                x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
-            heavy_parts[3] = x;
-            printf("[Optimized] Heavy[3] on thread %d\n", omp_get_thread_num());
+    Plan plan;
+    plan_build(&plan, n_iters, cost, nthreads);
+    printf("[Plan] %d pieces, predicted imbalance %.2f\n",
+           plan.npieces, plan_predicted_imbalance(&plan));
+
+    double t_opt = 0.0, imb_opt = 1.0, ro[3];
+    int replans = 0;
+    for (int run = 0; run < PLAN_RUNS; run++) {
+        for (int t = 0; t < nthreads; t++) busy_opt[t].t = 0.0;
+        double t0 = omp_get_wtime();
+        plan_execute(&plan, ranges, ro, busy_opt, &team_opt);
+        t_opt += omp_get_wtime() - t0;
+        imb_opt = busy_imbalance(busy_opt, team_opt);
+        if (imb_opt > REPLAN_IMBALANCE && run + 1 < PLAN_RUNS) {
+            plan_measured_cost(&plan, cost);
+            plan_free(&plan);
+            plan_build(&plan, n_iters, cost, nthreads);
+            replans++;
         }
     }
-    r3 = heavy_parts[0] + heavy_parts[1] + heavy_parts[2] + heavy_parts[3];
-    double t_opt_end = omp_get_wtime();
-    double t_opt = t_opt_end - t_opt_start;
+    t_opt /= PLAN_RUNS;
+    r1 = ro[0]; r2 = ro[1]; r3 = ro[2];
 
-    printf("Time = %f seconds\n", t_opt);
+    printf("Time = %f seconds (mean of %d runs, %d re-plans)\n", t_opt, PLAN_RUNS, replans);
     printf("Speedup vs Sequential = %.2fx\n", t_seq / t_opt);
-    printf("Speedup vs Naive      = %.2fx\n\n", t_naive / t_opt);
+    printf("Speedup vs Naive      = %.2fx\n", t_naive / t_opt);
+    imb_opt = busy_report("Optimized", busy_opt, team_opt);
+    printf("\n");
+
+    /* ============ Task-based: taskloop with cost-sized chunks ============ */
+    /*
+     * The total estimated time (same calibration as above) is cut into
+     * CHUNKS_PER_THREAD * nthreads pieces, and each task gets a chunk length
+     * (in iterations) worth one piece of time. The chunks are taskloop
+     * iterations, so idle threads pick up the remaining ones whatever the
+     * thread count. Heavy chunks are generated first.
+     */
+    double piece = total_cost / (CHUNKS_PER_THREAD * nthreads);
+    long grain[3], nchunks[3];
+    for (int k = 0; k < 3; k++) {
+        grain[k] = (long)(piece / cost[k]);
+        if (grain[k] < 1) grain[k] = 1;
+        if (grain[k] > n_iters[k]) grain[k] = n_iters[k];
+        nchunks[k] = (n_iters[k] + grain[k] - 1) / grain[k];
+    }
+    printf("=== Task-based (taskloop) ===\n");
+    printf("Chunks:         light=%ld moderate=%ld heavy=%ld\n",
+           nchunks[0], nchunks[1], nchunks[2]);
+
+    double t_task_start = omp_get_wtime();
+    double rt[3] = {0.0, 0.0, 0.0};
+    #pragma omp parallel
+    #pragma omp single
+    {
+        team_task = omp_get_num_threads();
+        for (int k = 2; k >= 0; k--) {
+            double rk = 0.0;
+            #pragma omp taskloop grainsize(1) reduction(+:rk)
+            for (long c = 0; c < nchunks[k]; c++) {
+                double t0 = omp_get_wtime();
+                long lo = c * grain[k];
+                long hi = lo + grain[k] < n_iters[k] ? lo + grain[k] : n_iters[k];
+                rk += ranges[k](lo, hi);
+                busy_task[omp_get_thread_num()].t += omp_get_wtime() - t0;
+            }
+            rt[k] = rk;
+        }
+    }
+    double t_task_end = omp_get_wtime();
+    double t_task = t_task_end - t_task_start;
+
+    printf("Time = %f seconds\n", t_task);
+    printf("Speedup vs Sequential = %.2fx\n", t_seq / t_task);
+    printf("Speedup vs Optimized  = %.2fx\n", t_opt / t_task);
+    double imb_task = busy_report("Taskloop", busy_task, team_task);
+    printf("Results diff vs plan: %e %e %e\n\n",
+           fabs(rt[0] - r1), fabs(rt[1] - r2), fabs(rt[2] - r3));
 
     /* ============ Summary ============ */
     printf("=== Summary ===\n");
-    printf("%-25s %10s %10s\n", "Version", "Time (s)", "Speedup");
-    printf("%-25s %10.4f %10s\n", "Sequential", t_seq, "1.00x");
-    printf("%-25s %10.4f %9.2fx\n", "Naive Sections", t_naive, t_seq / t_naive);
-    printf("%-25s %10.4f %9.2fx\n", "Optimized Sections", t_opt, t_seq / t_opt);
+    printf("Threads = %d\n", nthreads);
+    printf("%-25s %10s %10s %10s\n", "Version", "Time (s)", "Speedup", "Imbalance");
+    printf("%-25s %10.4f %10s %10s\n", "Sequential", t_seq, "1.00x", "-");
+    printf("%-25s %10.4f %9.2fx %10.2f\n", "Naive Sections", t_naive, t_seq / t_naive, imb_naive);
+    printf("%-25s %10.4f %9.2fx %10.2f\n", "Optimized (LPT plan)", t_opt, t_seq / t_opt, imb_opt);
+    printf("%-25s %10.4f %9.2fx %10.2f\n", "Taskloop (cost-sized)", t_task, t_seq / t_task, imb_task);
     printf("\nConclusion: Naive sections are limited by the heaviest task.\n");
-    printf("Splitting heavy work across sections improves load balance.\n");
+    printf("A measured cost model with LPT packing balances the work statically,\n");
+    printf("and cost-sized taskloop chunks balance it dynamically, at any thread count.\n");
 
+    plan_free(&plan);
+    free(busy_naive);
+    free(busy_opt);
+    free(busy_task);
     return 0;
 }
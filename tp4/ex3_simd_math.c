@@ -0,0 +1,377 @@
+/**
+ * TP4 - Exercise 3 (kernels): Vectorized sin/cos/sqrt for the load-balancing tasks
+ *
+ * task_light, task_moderate and task_heavy (ex3_load_balancing.c) spend
+ * their time in scalar libm calls. Three implementations are compared:
+ *
+ *   libm        scalar sin/cos/sqrt, as in ex3_load_balancing.c
+ *   simd        own sin/cos polynomials declared "omp declare simd", so the
+ *               loops vectorize; sqrt maps to the vector sqrt instruction.
+ *               Rounding and quadrant selection are branch-free and the
+ *               loops count with an int (the long to double conversion has
+ *               no vector form below AVX-512DQ), so baseline SSE2 suffices
+ *   recurrence  the arguments are arithmetic sequences x_i = i*h, so
+ *               sin/cos are advanced by a rotation of angle h:
+ *                 sin(x+h) = sin(x) cos(h) + cos(x) sin(h)
+ *                 cos(x+h) = cos(x) cos(h) - sin(x) sin(h)
+ *               with VLEN independent lanes (vectorizable) and an exact
+ *               libm re-seed every RESEED steps to bound error growth
+ *
+ * Polynomial error bound: after Cody-Waite reduction to |r| <= pi/4 the
+ * truncated Taylor series of degree 17 (sin) and 18 (cos) have remainders
+ * below (pi/4)^19/19! < 3e-19, far under 1 ulp; the observed error is set
+ * by rounding in Horner's scheme and in the reduction (a few ulp), for
+ * |x| < 1e5. The recurrence error grows with the number of steps since the
+ * last re-seed (about RESEED * eps in absolute terms).
+ *
+ * Throughput (million iterations / s) and the max error of sin/cos versus
+ * libm are reported for each implementation.
+ *
+ * Compile: gcc -O2 -fopenmp -fno-math-errno -o ex3_simd_math ex3_simd_math.c -lm
+ *          (-fno-math-errno lets sqrt vectorize)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <omp.h>
+
+#define VLEN   8      /* independent lanes of the recurrence */
+#define RESEED 1024   /* recurrence steps per lane between libm re-seeds */
+
+/* pi/2 split in three parts for Cody-Waite reduction */
+#define PIO2_1  1.57079632673412561417e+00
+#define PIO2_2  6.07710050630396597660e-11
+#define PIO2_3  2.02226624879595063154e-21
+#define TWO_OPI 6.36619772367581382433e-01
+
+/* 1.5 * 2^52: adding and subtracting it rounds to nearest, |x| < 2^51 */
+#define ROUND_MAGIC 6755399441055744.0
+
+/* Taylor coefficients (-1)^k / (2k+1)! and (-1)^k / (2k)! */
+#define S1 (-1.66666666666666666667e-01)
+#define S2 ( 8.33333333333333333333e-03)
+#define S3 (-1.98412698412698412698e-04)
+#define S4 ( 2.75573192239858906526e-06)
+#define S5 (-2.50521083854417187751e-08)
+#define S6 ( 1.60590438368216145994e-10)
+#define S7 (-7.64716373181981647590e-13)
+#define S8 ( 2.81145725434552076320e-15)
+#define C1 (-5.00000000000000000000e-01)
+#define C2 ( 4.16666666666666666667e-02)
+#define C3 (-1.38888888888888888889e-03)
+#define C4 ( 2.48015873015873015873e-05)
+#define C5 (-2.75573192239858906526e-07)
+#define C6 ( 2.08767569878680989792e-09)
+#define C7 (-1.14707455977297247139e-11)
+#define C8 ( 4.77947733238738529744e-14)
+#define C9 (-1.56192069685862264622e-16)
+
+#pragma omp declare simd
+static inline double poly_sin(double r) {
+    double z = r * r;
+    return r + r * z * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * (S6 + z * (S7 + z * S8)))))));
+}
+
+#pragma omp declare simd
+static inline double poly_cos(double r) {
+    double z = r * r;
+    return 1.0 + z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * (C6 + z * (C7 + z * (C8 + z * C9))))))));
+}
+
+/* Quadrant q = round(x * 2/pi) and remainder r = x - q*pi/2, |r| <= pi/4.
+ * The rounding uses ROUND_MAGIC: nearbyint is a call without SSE4.1. */
+#pragma omp declare simd
+static inline double reduce(double x, int *q) {
+    double k = (x * TWO_OPI + ROUND_MAGIC) - ROUND_MAGIC;
+    *q = (int)k;
+    return ((x - k * PIO2_1) - k * PIO2_2) - k * PIO2_3;
+}
+
+/* a if bit is 0, b if it is 1, without a branch: one product is by 0.0
+ * and the other by 1.0, so the result is exact */
+#pragma omp declare simd
+static inline double select_bit(double a, double b, int bit) {
+    double w = (double)bit;
+    return a * (1.0 - w) + b * w;
+}
+
+/* v if bit is 0, -v if it is 1, without a branch */
+#pragma omp declare simd
+static inline double flip_sign(double v, int bit) {
+    return v * (double)(1 - 2 * bit);
+}
+
+#pragma omp declare simd
+static inline double simd_sin(double x) {
+    int q;
+    double r = reduce(x, &q);
+    double s = poly_sin(r), c = poly_cos(r);
+    double v = select_bit(s, c, q & 1);
+    return flip_sign(v, (q >> 1) & 1);
+}
+
+#pragma omp declare simd
+static inline double simd_cos(double x) {
+    int q;
+    double r = reduce(x, &q);
+    double s = poly_sin(r), c = poly_cos(r);
+    double v = select_bit(c, s, q & 1);
+    return flip_sign(v, ((q + 1) >> 1) & 1);
+}
+
+/* ---------------- libm (reference) ---------------- */
+
+double light_libm(long n) {
+    double x = 0.0;
+    for (long i = 0; i < n; i++)
+        x += sin(i * 0.001);
+    return x;
+}
+
+double moderate_libm(long n) {
+    double x = 0.0;
+    for (long i = 0; i < n; i++)
+        x += sqrt(i * 0.5) * cos(i * 0.001);
+    return x;
+}
+
+double heavy_libm(long n) {
+    double x = 0.0;
+    for (long i = 0; i < n; i++)
+        x += sqrt(i * 0.5) * cos(i * 0.001) * sin(i * 0.0001);
+    return x;
+}
+
+/* ---------------- SIMD polynomials ---------------- */
+
+/* Blocks of SIMD_BLOCK iterations with an int counter; i = p + k is exact
+ * in double, so the arguments are those of the libm loops. */
+#define SIMD_BLOCK (1 << 20)
+
+double light_simd(long n) {
+    double x = 0.0;
+    for (long p = 0; p < n; p += SIMD_BLOCK) {
+        int m = n - p < SIMD_BLOCK ? (int)(n - p) : SIMD_BLOCK;
+        double base = (double)p;
+        #pragma omp simd reduction(+:x)
+        for (int k = 0; k < m; k++)
+            x += simd_sin((base + k) * 0.001);
+    }
+    return x;
+}
+
+double moderate_simd(long n) {
+    double x = 0.0;
+    for (long p = 0; p < n; p += SIMD_BLOCK) {
+        int m = n - p < SIMD_BLOCK ? (int)(n - p) : SIMD_BLOCK;
+        double base = (double)p;
+        #pragma omp simd reduction(+:x)
+        for (int k = 0; k < m; k++) {
+            double i = base + k;
+            x += sqrt(i * 0.5) * simd_cos(i * 0.001);
+        }
+    }
+    return x;
+}
+
+double heavy_simd(long n) {
+    double x = 0.0;
+    for (long p = 0; p < n; p += SIMD_BLOCK) {
+        int m = n - p < SIMD_BLOCK ? (int)(n - p) : SIMD_BLOCK;
+        double base = (double)p;
+        #pragma omp simd reduction(+:x)
+        for (int k = 0; k < m; k++) {
+            double i = base + k;
+            x += sqrt(i * 0.5) * simd_cos(i * 0.001) * simd_sin(i * 0.0001);
+        }
+    }
+    return x;
+}
+
+/* ---------------- Rotation recurrence ---------------- */
+
+#define PIECE (VLEN * RESEED)   /* one re-seed block, 64 KB per array */
+
+/*
+ * s[i] = sin((first+i)*h), c[i] = cos((first+i)*h) for i in [0, n),
+ * n <= PIECE. Lane l produces i = l + VLEN*j, rotated by VLEN*h per step.
+ */
+void sincos_recurrence(double h, double ch, double sh, long first, int n,
+                       double *s, double *c) {
+    double ls[VLEN], lc[VLEN];
+    for (int l = 0; l < VLEN; l++) {
+        ls[l] = sin((first + l) * h);
+        lc[l] = cos((first + l) * h);
+    }
+    for (int i = 0; i < n; i += VLEN) {
+        int m = n - i < VLEN ? n - i : VLEN;
+        for (int l = 0; l < m; l++) {
+            s[i + l] = ls[l];
+            c[i + l] = lc[l];
+        }
+        #pragma omp simd
+        for (int l = 0; l < VLEN; l++) {
+            double ns = ls[l] * ch + lc[l] * sh;
+            double nc = lc[l] * ch - ls[l] * sh;
+            ls[l] = ns;
+            lc[l] = nc;
+        }
+    }
+}
+
+double light_rec(long n) {
+    static double s[PIECE], c[PIECE];
+    double ch = cos(VLEN * 0.001), sh = sin(VLEN * 0.001), x = 0.0;
+    for (long p = 0; p < n; p += PIECE) {
+        int m = n - p < PIECE ? (int)(n - p) : PIECE;
+        sincos_recurrence(0.001, ch, sh, p, m, s, c);
+        #pragma omp simd reduction(+:x)
+        for (int i = 0; i < m; i++)
+            x += s[i];
+    }
+    return x;
+}
+
+double moderate_rec(long n) {
+    static double s[PIECE], c[PIECE];
+    double ch = cos(VLEN * 0.001), sh = sin(VLEN * 0.001), x = 0.0;
+    for (long p = 0; p < n; p += PIECE) {
+        int m = n - p < PIECE ? (int)(n - p) : PIECE;
+        sincos_recurrence(0.001, ch, sh, p, m, s, c);
+        #pragma omp simd reduction(+:x)
+        for (int i = 0; i < m; i++)
+            x += sqrt((p + i) * 0.5) * c[i];
+    }
+    return x;
+}
+
+double heavy_rec(long n) {
+    static double s1[PIECE], c1[PIECE], s2[PIECE], c2[PIECE];
+    double ch1 = cos(VLEN * 0.001),  sh1 = sin(VLEN * 0.001);
+    double ch2 = cos(VLEN * 0.0001), sh2 = sin(VLEN * 0.0001), x = 0.0;
+    for (long p = 0; p < n; p += PIECE) {
+        int m = n - p < PIECE ? (int)(n - p) : PIECE;
+        sincos_recurrence(0.001,  ch1, sh1, p, m, s1, c1);
+        sincos_recurrence(0.0001, ch2, sh2, p, m, s2, c2);
+        #pragma omp simd reduction(+:x)
+        for (int i = 0; i < m; i++)
+            x += sqrt((p + i) * 0.5) * c1[i] * s2[i];
+    }
+    return x;
+}
+
+/* ---------------- Accuracy ---------------- */
+
+/* Distance in units in the last place between two doubles */
+static double ulp_diff(double a, double b) {
+    int64_t ia, ib;
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+    if (ia < 0) ia = INT64_MIN - ia;   /* map to a monotonic integer line */
+    if (ib < 0) ib = INT64_MIN - ib;
+    if ((ia < 0) != (ib < 0))          /* opposite signs: avoid overflow */
+        return fabs((double)ia) + fabs((double)ib);
+    return (double)(ia > ib ? ia - ib : ib - ia);
+}
+
+typedef struct {
+    double ulp;
+    double abs;
+} Err;
+
+static void err_update(Err *e, double got, double ref) {
+    double u = ulp_diff(got, ref), a = fabs(got - ref);
+    if (u > e->ulp) e->ulp = u;
+    if (a > e->abs) e->abs = a;
+}
+
+/* Max error of sin/cos over x = i*h, i in [0, n) */
+static void accuracy(double h, long n, Err *simd_s, Err *simd_c, Err *rec_s, Err *rec_c) {
+    static double s[PIECE], c[PIECE];
+    double ch = cos(VLEN * h), sh = sin(VLEN * h);
+    for (long p = 0; p < n; p += PIECE) {
+        int m = n - p < PIECE ? (int)(n - p) : PIECE;
+        sincos_recurrence(h, ch, sh, p, m, s, c);
+        for (int i = 0; i < m; i++) {
+            double x = (p + i) * h, rs = sin(x), rc = cos(x);
+            err_update(simd_s, simd_sin(x), rs);
+            err_update(simd_c, simd_cos(x), rc);
+            err_update(rec_s, s[i], rs);
+            err_update(rec_c, c[i], rc);
+        }
+    }
+}
+
+/* Best of 3 runs, returns seconds and stores the result */
+static double bench(double (*f)(long), long n, double *result) {
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = omp_get_wtime();
+        *result = f(n);
+        double t = omp_get_wtime() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    long N_WORK = 1000000;
+    if (argc > 1) N_WORK = atol(argv[1]);
+    if (N_WORK <= 0) {
+        printf("Usage: %s [N_WORK]\n", argv[0]);
+        return 1;
+    }
+
+    printf("TP4 Exercise 3: Vectorized math kernels\n");
+    printf("=======================================\n");
+    printf("Task A (light):    %ld iterations\n", N_WORK);
+    printf("Task B (moderate): %ld iterations\n", 5*N_WORK);
+    printf("Task C (heavy):    %ld iterations\n\n", 20*N_WORK);
+
+    const char *tasks[3] = { "light", "moderate", "heavy" };
+    const char *impls[3] = { "libm", "simd", "recurrence" };
+    long iters[3] = { N_WORK, 5*N_WORK, 20*N_WORK };
+    double (*funcs[3][3])(long) = {
+        { light_libm,    light_simd,    light_rec },
+        { moderate_libm, moderate_simd, moderate_rec },
+        { heavy_libm,    heavy_simd,    heavy_rec },
+    };
+
+    printf("=== Throughput ===\n");
+    printf("%-10s %-12s %10s %12s %10s %14s\n",
+           "Task", "Impl", "Time (s)", "Mit/s", "Speedup", "Rel. diff");
+    for (int t = 0; t < 3; t++) {
+        double ref = 0.0, t_ref = 0.0;
+        for (int k = 0; k < 3; k++) {
+            double r;
+            double time = bench(funcs[t][k], iters[t], &r);
+            if (k == 0) { ref = r; t_ref = time; }
+            printf("%-10s %-12s %10.4f %12.1f %9.2fx %14.3e\n",
+                   tasks[t], impls[k], time, iters[t] / time / 1e6,
+                   t_ref / time, fabs(r - ref) / fabs(ref));
+        }
+    }
+
+    /* Accuracy over the argument ranges the tasks actually use */
+    printf("\n=== Accuracy vs libm ===\n");
+    printf("%-22s %-12s %12s %12s\n", "Function", "Impl", "Max ulp", "Max abs err");
+    double steps[2] = { 0.001, 0.0001 };
+    for (int k = 0; k < 2; k++) {
+        Err es = {0, 0}, ec = {0, 0}, rs = {0, 0}, rc = {0, 0};
+        accuracy(steps[k], 20*N_WORK, &es, &ec, &rs, &rc);
+        char name[32];
+        snprintf(name, sizeof(name), "sin(i*%g)", steps[k]);
+        printf("%-22s %-12s %12.0f %12.3e\n", name, "simd", es.ulp, es.abs);
+        printf("%-22s %-12s %12.0f %12.3e\n", name, "recurrence", rs.ulp, rs.abs);
+        snprintf(name, sizeof(name), "cos(i*%g)", steps[k]);
+        printf("%-22s %-12s %12.0f %12.3e\n", name, "simd", ec.ulp, ec.abs);
+        printf("%-22s %-12s %12.0f %12.3e\n", name, "recurrence", rc.ulp, rc.abs);
+    }
+    printf("\nRecurrence ulp errors peak where sin/cos cross zero: the absolute\n");
+    printf("error stays near RESEED * eps while the value itself goes to 0.\n");
+
+    return 0;
+}
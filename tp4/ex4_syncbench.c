@@ -0,0 +1,394 @@
+/**
+ * TP4 - Exercise 4 (suite): Synchronization overhead microbenchmarks
+ *
+ * EPCC-style measurement: every thread executes a short delay() inside the
+ * construct, INNER_REPS times. The same delays executed without the
+ * construct give a reference time, and
+ *
+ *     overhead = (t_test - t_reference) / INNER_REPS
+ *
+ * is the cost of one occurrence of the construct. Each test is repeated
+ * OUTER_REPS times and the fastest repetition is kept.
+ *
+ * Constructs: parallel, for, barrier, single, critical, lock, atomic,
+ * reduction, for with static / static,1 / dynamic,1 / guided,1 schedules,
+ * and three hand-written barriers (centralized sense-reversing, static
+ * tree, dissemination). Thread counts go from 1 to all cores.
+ *
+ * Usage: ./ex4_syncbench [--max-threads T] [--reps R] [--delay D] [--csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <omp.h>
+
+#define CACHE_LINE   64
+#define OUTER_REPS   10
+#define MAX_ROUNDS   16     /* dissemination rounds: log2(threads) */
+#define SPIN_YIELD   1024   /* spins before yielding the core */
+#define ITERS_PER_THREAD 16  /* loop iterations per thread in schedule tests */
+
+static int inner_reps = 1000;
+static int delay_length = 200;
+
+/* Receives the counters of the atomic and reduction tests */
+static volatile double sink;
+
+/* Busy work the compiler cannot remove */
+static void delay(int length) {
+    volatile double a = 0.0;
+    for (int i = 0; i < length; i++)
+        a += i;
+}
+
+/* Per-iteration delay of the schedule tests */
+static int schedule_delay(void) {
+    return delay_length / ITERS_PER_THREAD > 0 ? delay_length / ITERS_PER_THREAD : 1;
+}
+
+static inline void spin_wait(int *spins) {
+    if (++*spins == SPIN_YIELD) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+/* ---------------- Hand-written barriers ---------------- */
+
+typedef struct {
+    long value;
+    char pad[CACHE_LINE - sizeof(long)];
+} PaddedFlag;
+
+/* Centralized sense-reversing barrier */
+typedef struct {
+    PaddedFlag count;
+    PaddedFlag sense;
+} CentralBarrier;
+
+static void central_wait(CentralBarrier *b, long *local_sense, int nthreads) {
+    *local_sense = !*local_sense;
+    if (__atomic_add_fetch(&b->count.value, 1, __ATOMIC_ACQ_REL) == nthreads) {
+        __atomic_store_n(&b->count.value, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&b->sense.value, *local_sense, __ATOMIC_RELEASE);
+    } else {
+        int spins = 0;
+        while (__atomic_load_n(&b->sense.value, __ATOMIC_ACQUIRE) != *local_sense)
+            spin_wait(&spins);
+    }
+}
+
+/* Static binary tree: thread i waits for children 2i+1 and 2i+2, then
+ * reports to its parent; the root releases everybody through one flag.
+ * Flags hold episode numbers, so they never need resetting. */
+typedef struct {
+    PaddedFlag *arrive;   /* one per thread */
+    PaddedFlag release;
+} TreeBarrier;
+
+static void tree_wait(TreeBarrier *b, long *episode, int tid, int nthreads) {
+    long e = ++*episode;
+    int spins = 0;
+    for (int child = 2 * tid + 1; child <= 2 * tid + 2 && child < nthreads; child++)
+        while (__atomic_load_n(&b->arrive[child].value, __ATOMIC_ACQUIRE) < e)
+            spin_wait(&spins);
+    if (tid == 0) {
+        __atomic_store_n(&b->release.value, e, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&b->arrive[tid].value, e, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&b->release.value, __ATOMIC_ACQUIRE) < e)
+            spin_wait(&spins);
+    }
+}
+
+/* Dissemination barrier: in round r thread i signals (i + 2^r) mod T and
+ * waits for the signal of (i - 2^r) mod T. */
+typedef struct {
+    PaddedFlag *flags;    /* nthreads * MAX_ROUNDS */
+    int rounds;
+} DissemBarrier;
+
+static void dissem_wait(DissemBarrier *b, long *episode, int tid, int nthreads) {
+    long e = ++*episode;
+    int spins = 0;
+    for (int r = 0, dist = 1; r < b->rounds; r++, dist *= 2) {
+        int partner = (tid + dist) % nthreads;
+        __atomic_store_n(&b->flags[partner * MAX_ROUNDS + r].value, e, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&b->flags[tid * MAX_ROUNDS + r].value, __ATOMIC_ACQUIRE) < e)
+            spin_wait(&spins);
+    }
+}
+
+/* ---------------- Tests ---------------- */
+
+enum {
+    T_PARALLEL, T_FOR, T_BARRIER, T_SINGLE, T_CRITICAL, T_LOCK, T_ATOMIC,
+    T_REDUCTION, T_STATIC, T_STATIC1, T_DYNAMIC1, T_GUIDED1,
+    T_CENTRAL, T_TREE, T_DISSEM, NTESTS
+};
+
+static const char *test_names[NTESTS] = {
+    "parallel", "for", "barrier", "single", "critical", "lock", "atomic",
+    "reduction", "for_static", "for_static1", "for_dynamic1", "for_guided1",
+    "central_bar", "tree_bar", "dissem_bar"
+};
+
+/* Time of one repetition of the test body with nthreads threads */
+static double run_test(int test, int nthreads) {
+    double t0 = 0.0;
+    int reps = inner_reps;
+
+    switch (test) {
+    case T_PARALLEL:
+        t0 = omp_get_wtime();
+        for (int j = 0; j < reps; j++) {
+            #pragma omp parallel num_threads(nthreads)
+            delay(delay_length);
+        }
+        break;
+
+    case T_FOR:
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps; j++) {
+            #pragma omp for schedule(static)
+            for (int i = 0; i < nthreads; i++)
+                delay(delay_length);
+        }
+        break;
+
+    case T_BARRIER:
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps; j++) {
+            delay(delay_length);
+            #pragma omp barrier
+        }
+        break;
+
+    case T_SINGLE:
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps; j++) {
+            #pragma omp single
+            delay(delay_length);
+        }
+        break;
+
+    /* Mutual exclusion tests: the delay is inside the construct and runs
+     * serialized, so reps/nthreads entries per thread make reps delays in
+     * total, as for the other tests. */
+    case T_CRITICAL:
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps / nthreads; j++) {
+            #pragma omp critical
+            delay(delay_length);
+        }
+        break;
+
+    case T_LOCK: {
+        omp_lock_t lock;
+        omp_init_lock(&lock);
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps / nthreads; j++) {
+            omp_set_lock(&lock);
+            delay(delay_length);
+            omp_unset_lock(&lock);
+        }
+        omp_destroy_lock(&lock);
+        break;
+    }
+
+    /* The delay cannot run inside an atomic, so it runs in parallel: every
+     * thread does reps delays and reps atomics, and the reference is the
+     * reps delays of one thread, as for barrier. */
+    case T_ATOMIC: {
+        double counter = 0.0;
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps; j++) {
+            delay(delay_length);
+            #pragma omp atomic
+            counter += 1.0;
+        }
+        sink = counter;
+        break;
+    }
+
+    case T_REDUCTION: {
+        double sum = 0.0;
+        t0 = omp_get_wtime();
+        for (int j = 0; j < reps; j++) {
+            #pragma omp parallel num_threads(nthreads) reduction(+:sum)
+            {
+                delay(delay_length);
+                sum += 1.0;
+            }
+        }
+        sink = sum;
+        break;
+    }
+
+    /* Schedule tests: ITERS_PER_THREAD iterations per thread per rep, each a
+     * delay of delay_length / ITERS_PER_THREAD, against their own reference. */
+    case T_STATIC:
+    case T_STATIC1:
+    case T_DYNAMIC1:
+    case T_GUIDED1: {
+        omp_sched_t kind = test == T_DYNAMIC1 ? omp_sched_dynamic :
+                           test == T_GUIDED1  ? omp_sched_guided : omp_sched_static;
+        omp_set_schedule(kind, test == T_STATIC ? 0 : 1);
+        int len = schedule_delay();
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        for (int j = 0; j < reps; j++) {
+            #pragma omp for schedule(runtime)
+            for (int i = 0; i < nthreads * ITERS_PER_THREAD; i++)
+                delay(len);
+        }
+        break;
+    }
+
+    case T_CENTRAL: {
+        CentralBarrier *b = aligned_alloc(CACHE_LINE, sizeof(CentralBarrier));
+        b->count.value = 0;
+        b->sense.value = 0;
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        {
+            long sense = 0;
+            int nt = omp_get_num_threads();
+            for (int j = 0; j < reps; j++) {
+                delay(delay_length);
+                central_wait(b, &sense, nt);
+            }
+        }
+        free(b);
+        break;
+    }
+
+    case T_TREE: {
+        TreeBarrier b;
+        b.arrive = aligned_alloc(CACHE_LINE, nthreads * sizeof(PaddedFlag));
+        for (int i = 0; i < nthreads; i++) b.arrive[i].value = 0;
+        b.release.value = 0;
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        {
+            long episode = 0;
+            int nt = omp_get_num_threads(), tid = omp_get_thread_num();
+            for (int j = 0; j < reps; j++) {
+                delay(delay_length);
+                tree_wait(&b, &episode, tid, nt);
+            }
+        }
+        free(b.arrive);
+        break;
+    }
+
+    case T_DISSEM: {
+        DissemBarrier b;
+        b.rounds = 0;
+        while ((1 << b.rounds) < nthreads) b.rounds++;
+        b.flags = aligned_alloc(CACHE_LINE, (size_t)nthreads * MAX_ROUNDS * sizeof(PaddedFlag));
+        for (int i = 0; i < nthreads * MAX_ROUNDS; i++) b.flags[i].value = 0;
+        t0 = omp_get_wtime();
+        #pragma omp parallel num_threads(nthreads)
+        {
+            long episode = 0;
+            int nt = omp_get_num_threads(), tid = omp_get_thread_num();
+            for (int j = 0; j < reps; j++) {
+                delay(delay_length);
+                dissem_wait(&b, &episode, tid, nt);
+            }
+        }
+        free(b.flags);
+        break;
+    }
+    }
+
+    return omp_get_wtime() - t0;
+}
+
+static int is_schedule_test(int test) {
+    return test >= T_STATIC && test <= T_GUIDED1;
+}
+
+/* Reference: the same delays one thread executes, without the construct */
+static double run_reference(int schedule) {
+    int per_rep = schedule ? ITERS_PER_THREAD : 1;
+    int len = schedule ? schedule_delay() : delay_length;
+    double t0 = omp_get_wtime();
+    for (int j = 0; j < inner_reps; j++)
+        for (int i = 0; i < per_rep; i++)
+            delay(len);
+    return omp_get_wtime() - t0;
+}
+
+/* test < 0 selects a reference: -1 plain, -2 schedule tests */
+static double best_of(int test, int nthreads) {
+    double best = 1e30;
+    for (int rep = 0; rep < OUTER_REPS; rep++) {
+        double t = test < 0 ? run_reference(test == -2) : run_test(test, nthreads);
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int max_threads = omp_get_num_procs();
+    int csv_mode = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-threads") == 0 && i+1 < argc)
+            max_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && i+1 < argc)
+            inner_reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--delay") == 0 && i+1 < argc)
+            delay_length = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0)
+            csv_mode = 1;
+    }
+    if (max_threads < 1 || inner_reps < 1 || delay_length < 1) {
+        printf("Usage: %s [--max-threads T] [--reps R] [--delay D] [--csv]\n", argv[0]);
+        return 1;
+    }
+    if (max_threads > (1 << MAX_ROUNDS)) max_threads = 1 << MAX_ROUNDS;
+
+    /* References are independent of the thread count */
+    double t_ref = best_of(-1, 1);
+    double t_ref_sched = best_of(-2, 1);
+
+    if (csv_mode) {
+        printf("threads,construct,overhead_us\n");
+    } else {
+        printf("TP4 Exercise 4: Synchronization overhead (EPCC method)\n");
+        printf("======================================================\n");
+        printf("Inner reps: %d, delay: %d (%.3f us), outer reps: %d\n\n",
+               inner_reps, delay_length, t_ref / inner_reps * 1e6, OUTER_REPS);
+        printf("%-8s", "Threads");
+        for (int t = 0; t < NTESTS; t++) printf(" %15s", test_names[t]);
+        printf("\n");
+    }
+
+    for (int nt = 1; ; nt = (2 * nt > max_threads && nt < max_threads) ? max_threads : 2 * nt) {
+        if (!csv_mode) printf("%-8d", nt);
+        for (int t = 0; t < NTESTS; t++) {
+            double ref = is_schedule_test(t) ? t_ref_sched : t_ref;
+            double overhead = (best_of(t, nt) - ref) / inner_reps * 1e6;
+            if (csv_mode)
+                printf("%d,%s,%.4f\n", nt, test_names[t], overhead);
+            else
+                printf(" %15.3f", overhead);
+        }
+        if (!csv_mode) printf("\n");
+        if (nt >= max_threads) break;
+    }
+    if (!csv_mode) printf("\nOverheads in microseconds per construct.\n");
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+# Tuning run for the collectives layer
+# Usage: bash benchmark.sh
+# Then: export COLL_TUNING=$PWD/coll_tuning.txt before running ex2, ex5 or tp6/distrib_grad
+set -euo pipefail
+
+EXE="./coll_tune"
+
+# Compile
+mpicc -O2 -o coll_tune coll_tune.c coll.c
+
+# Clear previous results
+rm -f coll.csv coll_tuning.txt
+echo "op,algorithm,bytes,P,time" > coll.csv
+
+PROCS=(2 3 4 6 8)
+
+for P in "${PROCS[@]}"; do
+    echo "Running: P=$P"
+    mpirun --oversubscribe -np "$P" "$EXE" --max-bytes 4194304
+done
+
+echo ""
+echo "Results saved to coll.csv, selection table to coll_tuning.txt"
+cat coll_tuning.txt
@@ -0,0 +1,531 @@
+/*
+ * TP5 - Collectives on top of point-to-point (see coll.h)
+ *
+ * Cost model for n bytes on P ranks (alpha: latency, beta: time per byte):
+ *   binomial / recursive doubling   log2(P) * (alpha + n * beta)
+ *   Rabenseifner                    2 log2(P) * alpha + 2 n beta (P-1)/P
+ *   ring                            2 (P-1) * alpha + 2 n beta (P-1)/P
+ * so the tree algorithms win for small messages and the bandwidth-optimal
+ * ones for large; where the crossover lies is measured by coll_tune.
+ *
+ * All messages use tag COLL_TAG on the caller's communicator; as for the
+ * MPI collectives, every rank must call in the same order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coll.h"
+
+#define COLL_TAG 7001
+#define MAX_TUNING 1024
+
+/* Built-in thresholds when no tuning table is loaded */
+#define SMALL_BYTES 2048          /* tree algorithms up to here */
+#define BCAST_MIN_RANKS 8         /* scatter-allgather broadcast needs this many ranks */
+
+static const char *op_names[COLL_NOPS] = { "bcast", "reduce", "allreduce" };
+static const char *algo_names[COLL_NALGOS] = {
+    "mpi", "binomial", "scatter_allgather", "recursive_doubling", "rabenseifner", "ring"
+};
+
+typedef struct {
+    CollOp op;
+    int nranks;
+    long bytes;
+    CollAlgorithm algo;
+} TuningEntry;
+
+static TuningEntry tuning[MAX_TUNING];
+static int n_tuning = 0;
+static int tuning_checked = 0;
+
+const char *collOpName(CollOp op) {
+    return op >= 0 && op < COLL_NOPS ? op_names[op] : "unknown";
+}
+
+const char *collAlgorithmName(CollAlgorithm algo) {
+    return algo >= 0 && algo < COLL_NALGOS ? algo_names[algo] : "auto";
+}
+
+CollAlgorithm collAlgorithmFromName(const char *name) {
+    for (int a = 0; a < COLL_NALGOS; a++)
+        if (strcmp(name, algo_names[a]) == 0) return (CollAlgorithm)a;
+    return COLL_AUTO;
+}
+
+int collSupports(CollOp op, CollAlgorithm algo) {
+    switch (op) {
+    case COLL_BCAST:
+        return algo == COLL_MPI || algo == COLL_BINOMIAL || algo == COLL_SCATTER_ALLGATHER;
+    case COLL_REDUCE:
+        return algo == COLL_MPI || algo == COLL_BINOMIAL || algo == COLL_RABENSEIFNER;
+    case COLL_ALLREDUCE:
+        return algo == COLL_MPI || algo == COLL_RECURSIVE_DOUBLING ||
+               algo == COLL_RABENSEIFNER || algo == COLL_RING;
+    default:
+        return 0;
+    }
+}
+
+int collLoadTuning(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char op_name[16], algo_name[32];
+    int nranks;
+    long bytes;
+    n_tuning = 0;
+    while (n_tuning < MAX_TUNING &&
+           fscanf(f, "%15s %d %ld %31s", op_name, &nranks, &bytes, algo_name) == 4) {
+        int op;
+        for (op = 0; op < COLL_NOPS; op++)
+            if (strcmp(op_name, op_names[op]) == 0) break;
+        CollAlgorithm algo = collAlgorithmFromName(algo_name);
+        if (op == COLL_NOPS || !collSupports((CollOp)op, algo)) continue;
+
+        tuning[n_tuning].op = (CollOp)op;
+        tuning[n_tuning].nranks = nranks;
+        tuning[n_tuning].bytes = bytes;
+        tuning[n_tuning].algo = algo;
+        n_tuning++;
+    }
+    fclose(f);
+    tuning_checked = 1;
+    return n_tuning;
+}
+
+/* First automatic selection: rank 0 of comm reads COLL_TUNING and
+ * broadcasts the table, so that every rank picks the same algorithm even if
+ * the file is missing or differs on some nodes. */
+static void syncTuning(MPI_Comm comm) {
+    if (tuning_checked) return;
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    if (rank == 0) {
+        const char *path = getenv("COLL_TUNING");
+        if (path && collLoadTuning(path) < 0)
+            fprintf(stderr, "coll: cannot read tuning table %s, using defaults\n", path);
+    }
+    MPI_Bcast(&n_tuning, 1, MPI_INT, 0, comm);
+    if (n_tuning > 0)
+        MPI_Bcast(tuning, n_tuning * (int)sizeof(TuningEntry), MPI_BYTE, 0, comm);
+    tuning_checked = 1;
+}
+
+/* Table lookup: entries for the largest measured rank count <= nranks (or
+ * the smallest one), then the smallest size bound >= bytes (or the largest) */
+static CollAlgorithm lookupTuning(CollOp op, int nranks, long bytes) {
+    int best_p = -1, min_p = -1;
+    for (int i = 0; i < n_tuning; i++) {
+        if (tuning[i].op != op) continue;
+        if (tuning[i].nranks <= nranks && tuning[i].nranks > best_p) best_p = tuning[i].nranks;
+        if (min_p < 0 || tuning[i].nranks < min_p) min_p = tuning[i].nranks;
+    }
+    if (best_p < 0) best_p = min_p;
+    if (best_p < 0) return COLL_AUTO;
+
+    int fit = -1, largest = -1;
+    for (int i = 0; i < n_tuning; i++) {
+        if (tuning[i].op != op || tuning[i].nranks != best_p) continue;
+        if (tuning[i].bytes >= bytes && (fit < 0 || tuning[i].bytes < tuning[fit].bytes)) fit = i;
+        if (largest < 0 || tuning[i].bytes > tuning[largest].bytes) largest = i;
+    }
+    return tuning[fit >= 0 ? fit : largest].algo;
+}
+
+CollAlgorithm collSelect(CollOp op, int nranks, long bytes) {
+    CollAlgorithm algo = lookupTuning(op, nranks, bytes);
+    if (algo != COLL_AUTO) return algo;
+
+    switch (op) {
+    case COLL_BCAST:
+        return bytes <= SMALL_BYTES || nranks < BCAST_MIN_RANKS ? COLL_BINOMIAL
+                                                                : COLL_SCATTER_ALLGATHER;
+    case COLL_REDUCE:
+        return bytes <= SMALL_BYTES ? COLL_BINOMIAL : COLL_RABENSEIFNER;
+    default:
+        return bytes <= SMALL_BYTES ? COLL_RECURSIVE_DOUBLING : COLL_RABENSEIFNER;
+    }
+}
+
+/* ---------- helpers ---------- */
+
+static MPI_Aint typeExtent(MPI_Datatype type) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    return extent;
+}
+
+/* Element offsets of nblocks nearly equal blocks: block b is
+ * [displs[b], displs[b+1]) */
+static int *blockDispls(int count, int nblocks) {
+    int *displs = malloc((nblocks + 1) * sizeof(int));
+    int base = count / nblocks, rem = count % nblocks;
+    displs[0] = 0;
+    for (int b = 0; b < nblocks; b++)
+        displs[b + 1] = displs[b] + base + (b < rem ? 1 : 0);
+    return displs;
+}
+
+static int pow2Below(int n) {
+    int p = 1;
+    while (2 * p <= n) p *= 2;
+    return p;
+}
+
+/* Rank in comm of member newrank of the power-of-two group */
+static int realRank(int newrank, int rem) {
+    return newrank < rem ? 2 * newrank + 1 : newrank + rem;
+}
+
+/* The first 2*rem ranks pair up: the even one hands its data to the odd
+ * one and sits out. Returns the rank in the power-of-two group, or -1. */
+static int foldIn(char *buf, char *tmp, int count, MPI_Datatype type, MPI_Op mpi_op,
+                  int rank, int rem, MPI_Comm comm) {
+    if (rank >= 2 * rem) return rank - rem;
+    if (rank % 2 == 0) {
+        MPI_Send(buf, count, type, rank + 1, COLL_TAG, comm);
+        return -1;
+    }
+    MPI_Recv(tmp, count, type, rank - 1, COLL_TAG, comm, MPI_STATUS_IGNORE);
+    MPI_Reduce_local(tmp, buf, count, type, mpi_op);
+    return rank / 2;
+}
+
+/* Hands the result back to the ranks that sat out */
+static void foldOut(char *buf, int count, MPI_Datatype type, int rank, int rem, MPI_Comm comm) {
+    if (rank >= 2 * rem) return;
+    if (rank % 2 == 1)
+        MPI_Send(buf, count, type, rank - 1, COLL_TAG, comm);
+    else
+        MPI_Recv(buf, count, type, rank + 1, COLL_TAG, comm, MPI_STATUS_IGNORE);
+}
+
+/* Recursive halving over the power-of-two group: at distance mask the
+ * partners exchange halves of their common window and each reduces the
+ * half it keeps. Member newrank ends with block newrank fully reduced. */
+static void halvingReduceScatter(char *buf, char *tmp, const int *displs, int pof2,
+                                 int newrank, int rem, MPI_Datatype type, MPI_Op mpi_op,
+                                 MPI_Comm comm) {
+    MPI_Aint ext = typeExtent(type);
+    int lo = 0, hi = pof2;
+    for (int mask = pof2 >> 1; mask > 0; mask >>= 1) {
+        int peer = realRank(newrank ^ mask, rem);
+        int mid = (lo + hi) / 2;
+        int upper = newrank & mask;
+        int keep_lo = upper ? mid : lo, keep_hi = upper ? hi : mid;
+        int send_lo = upper ? lo : mid, send_hi = upper ? mid : hi;
+        int keep = displs[keep_hi] - displs[keep_lo];
+
+        MPI_Sendrecv(buf + displs[send_lo] * ext, displs[send_hi] - displs[send_lo], type,
+                     peer, COLL_TAG, tmp + displs[keep_lo] * ext, keep, type, peer, COLL_TAG,
+                     comm, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(tmp + displs[keep_lo] * ext, buf + displs[keep_lo] * ext, keep,
+                         type, mpi_op);
+        lo = keep_lo;
+        hi = keep_hi;
+    }
+}
+
+/* Recursive doubling allgather of the blocks left by halvingReduceScatter */
+static void doublingAllgather(char *buf, const int *displs, int pof2, int newrank, int rem,
+                              MPI_Datatype type, MPI_Comm comm) {
+    MPI_Aint ext = typeExtent(type);
+    for (int mask = 1; mask < pof2; mask <<= 1) {
+        int partner = newrank ^ mask;
+        int peer = realRank(partner, rem);
+        int mine = newrank & ~(mask - 1), theirs = partner & ~(mask - 1);
+
+        MPI_Sendrecv(buf + displs[mine] * ext, displs[mine + mask] - displs[mine], type,
+                     peer, COLL_TAG, buf + displs[theirs] * ext,
+                     displs[theirs + mask] - displs[theirs], type, peer, COLL_TAG,
+                     comm, MPI_STATUS_IGNORE);
+    }
+}
+
+/* ---------- bcast ---------- */
+
+static void bcastBinomial(char *buf, long n, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+
+    /* Receive from the parent: vr with its lowest set bit cleared */
+    int mask = 1;
+    while (mask < size) {
+        if (vr & mask) {
+            MPI_Recv(buf, (int)n, MPI_BYTE, (vr - mask + root) % size, COLL_TAG, comm,
+                     MPI_STATUS_IGNORE);
+            break;
+        }
+        mask <<= 1;
+    }
+
+    /* Send to the children vr + mask for every lower bit */
+    for (mask >>= 1; mask > 0; mask >>= 1)
+        if (vr + mask < size)
+            MPI_Send(buf, (int)n, MPI_BYTE, (vr + mask + root) % size, COLL_TAG, comm);
+}
+
+/* Binomial scatter of P blocks indexed by relative rank, then ring allgather */
+static void bcastScatterAllgather(char *buf, long n, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+    int *displs = blockDispls((int)n, size);
+
+    int mask = 1;
+    while (mask < size) {
+        if (vr & mask) {
+            int last = vr + mask < size ? vr + mask : size;
+            MPI_Recv(buf + displs[vr], displs[last] - displs[vr], MPI_BYTE,
+                     (vr - mask + root) % size, COLL_TAG, comm, MPI_STATUS_IGNORE);
+            break;
+        }
+        mask <<= 1;
+    }
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (vr + mask < size) {
+            int first = vr + mask;
+            int last = vr + 2 * mask < size ? vr + 2 * mask : size;
+            MPI_Send(buf + displs[first], displs[last] - displs[first], MPI_BYTE,
+                     (first + root) % size, COLL_TAG, comm);
+        }
+    }
+
+    int right = (rank + 1) % size, left = (rank - 1 + size) % size;
+    for (int s = 0; s < size - 1; s++) {
+        int sb = (vr - s + size) % size, rb = (vr - s - 1 + size) % size;
+        MPI_Sendrecv(buf + displs[sb], displs[sb + 1] - displs[sb], MPI_BYTE, right, COLL_TAG,
+                     buf + displs[rb], displs[rb + 1] - displs[rb], MPI_BYTE, left, COLL_TAG,
+                     comm, MPI_STATUS_IGNORE);
+    }
+    free(displs);
+}
+
+int collBcastAlgo(void *buf, int count, MPI_Datatype type, int root,
+                  MPI_Comm comm, CollAlgorithm algo) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    long n = (long)count * typeExtent(type);
+    if (algo == COLL_AUTO) {
+        syncTuning(comm);
+        algo = collSelect(COLL_BCAST, size, n);
+    }
+
+    switch (algo) {
+    case COLL_MPI:
+        return MPI_Bcast(buf, count, type, root, comm);
+    case COLL_BINOMIAL:
+        bcastBinomial(buf, n, root, comm);
+        return MPI_SUCCESS;
+    case COLL_SCATTER_ALLGATHER:
+        bcastScatterAllgather(buf, n, root, comm);
+        return MPI_SUCCESS;
+    default:
+        return MPI_ERR_ARG;
+    }
+}
+
+/* ---------- reduce ---------- */
+
+static void reduceBinomial(char *buf, char *tmp, int count, MPI_Datatype type, MPI_Op mpi_op,
+                           int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+
+    /* Reduce the children vr + mask for every lower bit, then send to the parent */
+    for (int mask = 1; mask < size; mask <<= 1) {
+        if (vr & mask) {
+            MPI_Send(buf, count, type, (vr - mask + root) % size, COLL_TAG, comm);
+            break;
+        }
+        if (vr + mask < size) {
+            MPI_Recv(tmp, count, type, (vr + mask + root) % size, COLL_TAG, comm,
+                     MPI_STATUS_IGNORE);
+            MPI_Reduce_local(tmp, buf, count, type, mpi_op);
+        }
+    }
+}
+
+/* Reduce-scatter by recursive halving, then every member sends its block to root */
+static void reduceRabenseifner(char *buf, char *tmp, int count, MPI_Datatype type,
+                               MPI_Op mpi_op, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int pof2 = pow2Below(size), rem = size - pof2;
+    MPI_Aint ext = typeExtent(type);
+    int *displs = blockDispls(count, pof2);
+
+    int newrank = foldIn(buf, tmp, count, type, mpi_op, rank, rem, comm);
+    if (newrank >= 0) {
+        halvingReduceScatter(buf, tmp, displs, pof2, newrank, rem, type, mpi_op, comm);
+        if (rank != root)
+            MPI_Send(buf + displs[newrank] * ext, displs[newrank + 1] - displs[newrank], type,
+                     root, COLL_TAG, comm);
+    }
+
+    if (rank == root) {
+        MPI_Request *reqs = malloc(pof2 * sizeof(MPI_Request));
+        for (int b = 0; b < pof2; b++) {
+            reqs[b] = MPI_REQUEST_NULL;
+            if (realRank(b, rem) != rank)
+                MPI_Irecv(buf + displs[b] * ext, displs[b + 1] - displs[b], type,
+                          realRank(b, rem), COLL_TAG, comm, &reqs[b]);
+        }
+        MPI_Waitall(pof2, reqs, MPI_STATUSES_IGNORE);
+        free(reqs);
+    }
+    free(displs);
+}
+
+int collReduceAlgo(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                   MPI_Op mpi_op, int root, MPI_Comm comm, CollAlgorithm algo) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Aint ext = typeExtent(type);
+    long n = (long)count * ext;
+    if (algo == COLL_AUTO) {
+        syncTuning(comm);
+        algo = collSelect(COLL_REDUCE, size, n);
+    }
+
+    if (algo == COLL_MPI)
+        return MPI_Reduce(sendbuf, recvbuf, count, type, mpi_op, root, comm);
+    if (algo != COLL_BINOMIAL && algo != COLL_RABENSEIFNER)
+        return MPI_ERR_ARG;
+
+    /* Work in recvbuf on root, in a scratch buffer elsewhere */
+    char *buf = rank == root ? recvbuf : malloc(n);
+    char *tmp = malloc(n);
+    if (sendbuf != MPI_IN_PLACE) memcpy(buf, sendbuf, n);
+
+    if (algo == COLL_BINOMIAL)
+        reduceBinomial(buf, tmp, count, type, mpi_op, root, comm);
+    else
+        reduceRabenseifner(buf, tmp, count, type, mpi_op, root, comm);
+
+    if (rank != root) free(buf);
+    free(tmp);
+    return MPI_SUCCESS;
+}
+
+/* ---------- allreduce ---------- */
+
+static void allreduceRecursiveDoubling(char *buf, char *tmp, int count, MPI_Datatype type,
+                                       MPI_Op mpi_op, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int pof2 = pow2Below(size), rem = size - pof2;
+
+    int newrank = foldIn(buf, tmp, count, type, mpi_op, rank, rem, comm);
+    if (newrank >= 0) {
+        for (int mask = 1; mask < pof2; mask <<= 1) {
+            int peer = realRank(newrank ^ mask, rem);
+            MPI_Sendrecv(buf, count, type, peer, COLL_TAG, tmp, count, type, peer, COLL_TAG,
+                         comm, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(tmp, buf, count, type, mpi_op);
+        }
+    }
+    foldOut(buf, count, type, rank, rem, comm);
+}
+
+static void allreduceRabenseifner(char *buf, char *tmp, int count, MPI_Datatype type,
+                                  MPI_Op mpi_op, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int pof2 = pow2Below(size), rem = size - pof2;
+    int *displs = blockDispls(count, pof2);
+
+    int newrank = foldIn(buf, tmp, count, type, mpi_op, rank, rem, comm);
+    if (newrank >= 0) {
+        halvingReduceScatter(buf, tmp, displs, pof2, newrank, rem, type, mpi_op, comm);
+        doublingAllgather(buf, displs, pof2, newrank, rem, type, comm);
+    }
+    foldOut(buf, count, type, rank, rem, comm);
+    free(displs);
+}
+
+/* Ring reduce-scatter (after step s rank r holds block r - s - 1 summed
+ * over s + 2 ranks), then ring allgather of the reduced blocks */
+static void allreduceRing(char *buf, char *tmp, int count, MPI_Datatype type,
+                          MPI_Op mpi_op, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Aint ext = typeExtent(type);
+    int *displs = blockDispls(count, size);
+    int right = (rank + 1) % size, left = (rank - 1 + size) % size;
+
+    for (int s = 0; s < size - 1; s++) {
+        int sb = (rank - s + size) % size, rb = (rank - s - 1 + size) % size;
+        int rcount = displs[rb + 1] - displs[rb];
+        MPI_Sendrecv(buf + displs[sb] * ext, displs[sb + 1] - displs[sb], type, right, COLL_TAG,
+                     tmp + displs[rb] * ext, rcount, type, left, COLL_TAG,
+                     comm, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(tmp + displs[rb] * ext, buf + displs[rb] * ext, rcount, type, mpi_op);
+    }
+
+    for (int s = 0; s < size - 1; s++) {
+        int sb = (rank - s + 1 + size) % size, rb = (rank - s + size) % size;
+        MPI_Sendrecv(buf + displs[sb] * ext, displs[sb + 1] - displs[sb], type, right, COLL_TAG,
+                     buf + displs[rb] * ext, displs[rb + 1] - displs[rb], type, left, COLL_TAG,
+                     comm, MPI_STATUS_IGNORE);
+    }
+    free(displs);
+}
+
+int collAllreduceAlgo(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                      MPI_Op mpi_op, MPI_Comm comm, CollAlgorithm algo) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    long n = (long)count * typeExtent(type);
+    if (algo == COLL_AUTO) {
+        syncTuning(comm);
+        algo = collSelect(COLL_ALLREDUCE, size, n);
+    }
+
+    if (algo == COLL_MPI)
+        return MPI_Allreduce(sendbuf, recvbuf, count, type, mpi_op, comm);
+    if (!collSupports(COLL_ALLREDUCE, algo))
+        return MPI_ERR_ARG;
+
+    char *buf = recvbuf;
+    char *tmp = malloc(n);
+    if (sendbuf != MPI_IN_PLACE) memcpy(buf, sendbuf, n);
+
+    if (algo == COLL_RECURSIVE_DOUBLING)
+        allreduceRecursiveDoubling(buf, tmp, count, type, mpi_op, comm);
+    else if (algo == COLL_RABENSEIFNER)
+        allreduceRabenseifner(buf, tmp, count, type, mpi_op, comm);
+    else
+        allreduceRing(buf, tmp, count, type, mpi_op, comm);
+
+    free(tmp);
+    return MPI_SUCCESS;
+}
+
+/* ---------- auto-selecting entry points ---------- */
+
+int collBcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+    return collBcastAlgo(buf, count, type, root, comm, COLL_AUTO);
+}
+
+int collReduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+               MPI_Op mpi_op, int root, MPI_Comm comm) {
+    return collReduceAlgo(sendbuf, recvbuf, count, type, mpi_op, root, comm, COLL_AUTO);
+}
+
+int collAllreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                  MPI_Op mpi_op, MPI_Comm comm) {
+    return collAllreduceAlgo(sendbuf, recvbuf, count, type, mpi_op, comm, COLL_AUTO);
+}
@@ -0,0 +1,80 @@
+/*
+ * TP5 - Collectives on top of point-to-point
+ *
+ * Bcast, Reduce and Allreduce with a choice of algorithm:
+ *   bcast      mpi, binomial, scatter_allgather (binomial scatter + ring
+ *              allgather)
+ *   reduce     mpi, binomial, rabenseifner (reduce-scatter by recursive
+ *              halving + gather to root)
+ *   allreduce  mpi, recursive_doubling, rabenseifner (reduce-scatter by
+ *              recursive halving + allgather by recursive doubling), ring
+ *              (ring reduce-scatter + ring allgather)
+ * "mpi" calls the library's own collective. Non-power-of-two rank counts
+ * are folded into the largest power of two first (recursive doubling and
+ * Rabenseifner).
+ *
+ * The collBcast/collReduce/collAllreduce entry points take the same
+ * arguments as their MPI counterparts and pick the algorithm from the
+ * tuning table written by coll_tune (file named by the COLL_TUNING
+ * environment variable), or from built-in size thresholds when there is
+ * none. The table is read by rank 0 of the communicator of the first
+ * automatic call and broadcast, so all ranks agree on the algorithm; that
+ * first call should be on a communicator spanning every rank that uses coll
+ * (e.g. MPI_COMM_WORLD).
+ *
+ * Restrictions: contiguous datatypes, commutative operations.
+ */
+
+#ifndef COLL_H
+#define COLL_H
+
+#include <mpi.h>
+
+typedef enum {
+    COLL_BCAST,
+    COLL_REDUCE,
+    COLL_ALLREDUCE,
+    COLL_NOPS
+} CollOp;
+
+typedef enum {
+    COLL_MPI,
+    COLL_BINOMIAL,
+    COLL_SCATTER_ALLGATHER,
+    COLL_RECURSIVE_DOUBLING,
+    COLL_RABENSEIFNER,
+    COLL_RING,
+    COLL_NALGOS,
+    COLL_AUTO = -1
+} CollAlgorithm;
+
+/* Names as used in the tuning file and on the command line */
+const char *collOpName(CollOp op);
+const char *collAlgorithmName(CollAlgorithm algo);
+CollAlgorithm collAlgorithmFromName(const char *name); /* COLL_AUTO if unknown */
+int collSupports(CollOp op, CollAlgorithm algo);
+
+/* Tuning table: lines "op P bytes algorithm", meaning "with P ranks, use
+ * algorithm for messages up to bytes". Returns the number of entries read,
+ * or -1 if the file cannot be opened. Local: a rank that calls it skips the
+ * broadcast of COLL_TUNING, so call it on every rank or on none.
+ * collSelect looks up the table loaded on this rank. */
+int collLoadTuning(const char *path);
+CollAlgorithm collSelect(CollOp op, int nranks, long bytes);
+
+/* Explicit algorithm; COLL_AUTO selects. Return MPI error codes. */
+int collBcastAlgo(void *buf, int count, MPI_Datatype type, int root,
+                  MPI_Comm comm, CollAlgorithm algo);
+int collReduceAlgo(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                   MPI_Op mpi_op, int root, MPI_Comm comm, CollAlgorithm algo);
+int collAllreduceAlgo(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                      MPI_Op mpi_op, MPI_Comm comm, CollAlgorithm algo);
+
+/* Drop-in replacements for MPI_Bcast, MPI_Reduce and MPI_Allreduce */
+int collBcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm);
+int collReduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+               MPI_Op mpi_op, int root, MPI_Comm comm);
+int collAllreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                  MPI_Op mpi_op, MPI_Comm comm);
+
+#endif /* COLL_H */
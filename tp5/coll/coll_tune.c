@@ -0,0 +1,178 @@
+/*
+ * TP5 - Collective tuning benchmark
+ *
+ * Times every algorithm of coll.h for Bcast, Reduce and Allreduce of
+ * MPI_DOUBLE (MPI_SUM) on the current rank count, for message sizes from
+ * 8 B to --max-bytes. Each result is checked against the expected values
+ * first. The time of one call is the max over ranks of the average over
+ * the repetitions.
+ *
+ * Output (appended, so runs with several rank counts accumulate):
+ *   coll.csv          op,algorithm,bytes,P,time
+ *   coll_tuning.txt   "op P bytes algorithm": the fastest algorithm per size,
+ *                     read by collLoadTuning() / COLL_TUNING=coll_tuning.txt
+ *
+ * Compile: mpicc -O2 -o coll_tune coll_tune.c coll.c
+ * Run:     mpirun -np 4 ./coll_tune [--max-bytes B] [--tuning FILE]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "coll.h"
+
+#define MIN_BYTES 8
+#define DEFAULT_MAX_BYTES (4L << 20)
+#define SIZE_STEP 4                 /* message sizes 8, 32, 128, ... */
+#define REP_BYTES (64L << 20)       /* repetitions: about this many bytes per size */
+#define MAX_REPS 1000
+#define MIN_REPS 5
+
+/* Contribution of rank r to element i; sums stay exact in double */
+static double contribution(int r, long i) {
+    return (double)((r + 1) * (i % 7 + 1));
+}
+
+/* Runs one call; checks the result when check is set. Returns the number
+ * of wrong elements on this rank. */
+static long runOnce(CollOp op, CollAlgorithm algo, double *in, double *out, int count,
+                    int rank, int size, int check) {
+    if (check) {
+        for (long i = 0; i < count; i++) {
+            in[i] = op == COLL_BCAST ? (rank == 0 ? contribution(0, i) : -1.0)
+                                     : contribution(rank, i);
+            out[i] = -1.0;
+        }
+    }
+
+    switch (op) {
+    case COLL_BCAST:
+        collBcastAlgo(in, count, MPI_DOUBLE, 0, MPI_COMM_WORLD, algo);
+        break;
+    case COLL_REDUCE:
+        collReduceAlgo(in, out, count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD, algo);
+        break;
+    default:
+        collAllreduceAlgo(in, out, count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, algo);
+        break;
+    }
+    if (!check) return 0;
+
+    long bad = 0;
+    double ranks_sum = size * (size + 1) / 2.0;
+    for (long i = 0; i < count; i++) {
+        if (op == COLL_BCAST)
+            bad += in[i] != contribution(0, i);
+        else if (op == COLL_ALLREDUCE || rank == 0)
+            bad += out[i] != ranks_sum * (i % 7 + 1);
+    }
+    return bad;
+}
+
+int main(int argc, char *argv[]) {
+    long max_bytes = DEFAULT_MAX_BYTES;
+    const char *tuning_path = "coll_tuning.txt";
+    int rank, size;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--max-bytes") == 0 && a + 1 < argc) {
+            max_bytes = atol(argv[++a]);
+        } else if (strcmp(argv[a], "--tuning") == 0 && a + 1 < argc) {
+            tuning_path = argv[++a];
+        } else {
+            if (rank == 0)
+                printf("Usage: %s [--max-bytes B] [--tuning FILE]\n", argv[0]);
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    if (max_bytes < MIN_BYTES) max_bytes = MIN_BYTES;
+
+    long max_count = max_bytes / sizeof(double);
+    double *in = malloc(max_count * sizeof(double));
+    double *out = malloc(max_count * sizeof(double));
+    if (!in || !out) {
+        fprintf(stderr, "Rank %d: cannot allocate buffers\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    FILE *csv = NULL, *tuning = NULL;
+    if (rank == 0) {
+        csv = fopen("coll.csv", "a");
+        tuning = fopen(tuning_path, "a");
+        printf("Collective tuning, P=%d, MPI_DOUBLE / MPI_SUM, 8 B .. %ld B (us per call)\n",
+               size, max_bytes);
+    }
+
+    for (int op = 0; op < COLL_NOPS; op++) {
+        if (rank == 0) {
+            printf("\n--- %s ---\n%10s", collOpName(op), "bytes");
+            for (int a = 0; a < COLL_NALGOS; a++)
+                if (collSupports(op, a)) printf(" %19s", collAlgorithmName(a));
+            printf("   best\n");
+        }
+
+        for (long n = MIN_BYTES; n <= max_bytes; n *= SIZE_STEP) {
+            int count = (int)(n / sizeof(double));
+            int reps = (int)(REP_BYTES / n);
+            if (reps > MAX_REPS) reps = MAX_REPS;
+            if (reps < MIN_REPS) reps = MIN_REPS;
+
+            CollAlgorithm best = COLL_AUTO;
+            double best_t = 0.0;
+            if (rank == 0) printf("%10ld", n);
+
+            for (int a = 0; a < COLL_NALGOS; a++) {
+                if (!collSupports(op, a)) continue;
+
+                long bad = runOnce(op, a, in, out, count, rank, size, 1), total_bad = 0;
+                MPI_Allreduce(&bad, &total_bad, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+                if (total_bad != 0) {
+                    if (rank == 0)
+                        fprintf(stderr, "\nError: %s %s of %ld bytes: %ld wrong elements\n",
+                                collOpName(op), collAlgorithmName(a), n, total_bad);
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+
+                MPI_Barrier(MPI_COMM_WORLD);
+                double t0 = MPI_Wtime();
+                for (int r = 0; r < reps; r++)
+                    runOnce(op, a, in, out, count, rank, size, 0);
+                double t = (MPI_Wtime() - t0) / reps, t_max = 0.0;
+                MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+                if (rank == 0) {
+                    printf(" %19.2f", t_max * 1e6);
+                    if (best == COLL_AUTO || t_max < best_t) {
+                        best = a;
+                        best_t = t_max;
+                    }
+                    if (csv)
+                        fprintf(csv, "%s,%s,%ld,%d,%.12e\n", collOpName(op),
+                                collAlgorithmName(a), n, size, t_max);
+                }
+            }
+
+            if (rank == 0) {
+                printf("   %s\n", collAlgorithmName(best));
+                if (tuning)
+                    fprintf(tuning, "%s %d %ld %s\n", collOpName(op), size, n,
+                            collAlgorithmName(best));
+            }
+            if (n > max_bytes / SIZE_STEP) break;
+        }
+    }
+
+    if (rank == 0) printf("\nTuning table appended to %s\n", tuning_path);
+    if (csv) fclose(csv);
+    if (tuning) fclose(tuning);
+    free(in);
+    free(out);
+    MPI_Finalize();
+    return 0;
+}
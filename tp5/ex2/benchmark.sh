@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Benchmark script for Exercise 2: per-int vs batched broadcast of a stream
+# Usage: bash benchmark.sh [n_values]
+set -euo pipefail
+
+EXE="./ex2"
+N_VALUES="${1:-1000000}"
+INPUT="values.txt"
+
+# Compile
+mpicc -O2 -I../coll -o ex2 ex2.c ../coll/coll.c
+
+# Input stream: 0 .. N_VALUES-1
+seq 0 $((N_VALUES - 1)) > "$INPUT"
+
+# Clear previous results
+rm -f throughput.csv
+echo "mode,batch,P,values,time,values_per_s" > throughput.csv
+
+PROCS=(2 4 8)
+BATCHES=(64 1024 4096 65536)
+
+for P in "${PROCS[@]}"; do
+    echo "Running: P=$P  per-int"
+    mpirun --oversubscribe -np "$P" "$EXE" --per-int "$INPUT"
+    for B in "${BATCHES[@]}"; do
+        echo "Running: P=$P  batch=$B"
+        mpirun --oversubscribe -np "$P" "$EXE" --batch --batch-size "$B" "$INPUT"
+    done
+done
+
+rm -f "$INPUT"
+echo ""
+echo "Results saved to throughput.csv"
+cat throughput.csv
@@ -5,22 +5,236 @@
  * Each process prints its rank and the received value.
  * The loop stops when a negative integer is entered.
  *
- * Compile: mpicc -o ex2 ex2.c
+ * The interactive broadcast goes through collBcast (tp5/coll), which picks the
+ * algorithm from the tuning table named by COLL_TUNING.
+ *
+ * Stream modes (no prompts; input from FILE, or stdin when omitted; stop at
+ * end of input or at a negative value). Every rank "processes" the values
+ * it receives by counting and summing them; rank 0 reports values/second
+ * and appends it to throughput.csv. Both modes use the library broadcast
+ * (MPI_Bcast / MPI_Ibcast), so they differ only in batching.
+ *   --per-int       the loop above: one broadcast per value
+ *   --batch         values packed into buffers of --batch-size ints (at
+ *                   most MAX_BATCH); rank 0 fills one buffer while the
+ *                   previous one is broadcast with MPI_Ibcast, testing it
+ *                   every FILL_TEST values so that it progresses, and every
+ *                   rank sums batch k while batch k+1 is in flight (double
+ *                   buffering)
+ *
+ * Compile: mpicc -I../coll -o ex2 ex2.c ../coll/coll.c
  * Run:     mpirun -np 4 ./ex2
+ *          mpirun -np 4 ./ex2 --batch [--batch-size B] [FILE]
+ *          mpirun -np 4 ./ex2 --per-int [FILE]
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <mpi.h>
+#include "coll.h"
+
+#define DEFAULT_BATCH 4096
+#define MAX_BATCH (1 << 24)
+#define READ_BUF (64 * 1024)
+#define FILL_TEST 256   /* values read between MPI_Test calls in fillBatch */
+
+/* Batch layout: header, then up to batch_size values */
+#define HDR_COUNT 0     /* number of values in this batch */
+#define HDR_LAST 1      /* 1 if the stream ends with this batch */
+#define HDR_SIZE 2
+
+/* ---------- buffered integer reader (rank 0) ---------- */
+
+typedef struct {
+    FILE *f;
+    char buf[READ_BUF];
+    size_t pos, len;
+} Reader;
+
+static int readerByte(Reader *r) {
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, 1, READ_BUF, r->f);
+        r->pos = 0;
+        if (r->len == 0) return EOF;
+    }
+    return (unsigned char)r->buf[r->pos++];
+}
+
+/* Next integer of the stream; returns 0 at end of input */
+static int readInt(Reader *r, int *value) {
+    int c = readerByte(r);
+    while (c != EOF && c != '-' && (c < '0' || c > '9')) c = readerByte(r);
+    if (c == EOF) return 0;
+
+    int neg = c == '-';
+    if (neg) c = readerByte(r);
+    long v = 0;
+    while (c >= '0' && c <= '9') {
+        v = v * 10 + (c - '0');
+        c = readerByte(r);
+    }
+    *value = (int)(neg ? -v : v);
+    return 1;
+}
+
+/* Fills one batch; the stream ends at end of input or a negative value.
+ * pending, if not NULL, is the broadcast in flight meanwhile: it is tested
+ * every FILL_TEST values to drive its progress. */
+static void fillBatch(Reader *r, int *batch, int batch_size, MPI_Request *pending) {
+    int n = 0, value, done = 0;
+    batch[HDR_LAST] = 0;
+    while (n < batch_size) {
+        if (!readInt(r, &value) || value < 0) {
+            batch[HDR_LAST] = 1;
+            break;
+        }
+        batch[HDR_SIZE + n++] = value;
+        if (pending && !done && n % FILL_TEST == 0)
+            MPI_Test(pending, &done, MPI_STATUS_IGNORE);
+    }
+    batch[HDR_COUNT] = n;
+}
+
+/* ---------- stream modes ---------- */
+
+/* One broadcast per value; returns the number of values */
+static long streamPerInt(Reader *r, int rank, long long *sum) {
+    long count = 0;
+    int value;
+    for (;;) {
+        if (rank == 0 && !readInt(r, &value)) value = -1;
+        MPI_Bcast(&value, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (value < 0) break;
+        *sum += value;
+        count++;
+    }
+    return count;
+}
+
+/* Double-buffered batches: at step k, rank 0 fills buffer k+1 while batch k
+ * is broadcast; then every rank posts the broadcast of batch k+1 and sums
+ * batch k while it is in flight. */
+static long streamBatched(Reader *r, int batch_size, int rank, long long *sum) {
+    int len = HDR_SIZE + batch_size;
+    int *batch[2];
+    MPI_Request req[2];
+    batch[0] = malloc(len * sizeof(int));
+    batch[1] = malloc(len * sizeof(int));
+    if (!batch[0] || !batch[1]) {
+        fprintf(stderr, "Rank %d: cannot allocate batches of %d ints\n", rank, len);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    long count = 0;
+
+    if (rank == 0) fillBatch(r, batch[0], batch_size, NULL);
+    MPI_Ibcast(batch[0], len, MPI_INT, 0, MPI_COMM_WORLD, &req[0]);
+
+    for (int cur = 0;; cur = 1 - cur) {
+        int next = 1 - cur;
+        /* Rank 0 already knows whether batch cur is the last one */
+        if (rank == 0 && !batch[cur][HDR_LAST])
+            fillBatch(r, batch[next], batch_size, &req[cur]);
+
+        MPI_Wait(&req[cur], MPI_STATUS_IGNORE);
+        int last = batch[cur][HDR_LAST];
+        if (!last) MPI_Ibcast(batch[next], len, MPI_INT, 0, MPI_COMM_WORLD, &req[next]);
+
+        int n = batch[cur][HDR_COUNT];
+        const int *values = batch[cur] + HDR_SIZE;
+        for (int i = 0; i < n; i++) *sum += values[i];
+        count += n;
+
+        if (last) break;
+    }
+
+    free(batch[0]);
+    free(batch[1]);
+    return count;
+}
+
+static void runStream(int batched, int batch_size, const char *path, int rank, int size) {
+    Reader *r = NULL;
+    if (rank == 0) {
+        r = calloc(1, sizeof(Reader));
+        if (!r) {
+            fprintf(stderr, "Error: cannot allocate the reader\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        r->f = path ? fopen(path, "r") : stdin;
+        if (!r->f) {
+            fprintf(stderr, "Error: cannot open %s\n", path);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    long long sum = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t0 = MPI_Wtime();
+    long count = batched ? streamBatched(r, batch_size, rank, &sum)
+                         : streamPerInt(r, rank, &sum);
+    double t = MPI_Wtime() - t0, t_max = 0.0;
+    MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /* Every rank must have seen the same stream */
+    long long sums[2] = { sum, -sum }, extremes[2];
+    MPI_Reduce(sums, extremes, 2, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        const char *mode = batched ? "batch" : "per-int";
+        double rate = count / t_max;
+        printf("mode=%s batch=%d P=%d values=%ld sum=%lld time=%.6e values_per_s=%.4e%s\n",
+               mode, batched ? batch_size : 1, size, count, sum, t_max, rate,
+               extremes[0] == -extremes[1] ? "" : " (MISMATCH across ranks)");
+
+        FILE *f = fopen("throughput.csv", "a");
+        if (f) {
+            fprintf(f, "%s,%d,%d,%ld,%.12e,%.6e\n", mode, batched ? batch_size : 1, size,
+                    count, t_max, rate);
+            fclose(f);
+        }
+        if (path) fclose(r->f);
+        free(r);
+    }
+}
 
 int main(int argc, char *argv[]) {
     int rank, size;
     int value;
+    int stream = 0, batched = 0, batch_size = DEFAULT_BATCH;
+    int bad_args = 0;
+    const char *path = NULL;
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--batch") == 0) {
+            stream = batched = 1;
+        } else if (strcmp(argv[a], "--per-int") == 0) {
+            stream = 1;
+        } else if (strcmp(argv[a], "--batch-size") == 0 && a + 1 < argc) {
+            batch_size = atoi(argv[++a]);
+        } else if (argv[a][0] != '-' && !path) {
+            path = argv[a];
+        } else {
+            bad_args = 1;
+        }
+    }
+    if (bad_args || batch_size < 1 || batch_size > MAX_BATCH || (path && !stream)) {
+        if (rank == 0)
+            printf("Usage: %s [--batch [--batch-size B] | --per-int] [FILE]  (B <= %d)\n",
+                   argv[0], MAX_BATCH);
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (stream) {
+        runStream(batched, batch_size, path, rank, size);
+        MPI_Finalize();
+        return 0;
+    }
+
     do {
         /* Rank 0 reads the value from terminal */
         if (rank == 0) {
@@ -32,7 +246,7 @@ int main(int argc, char *argv[]) {
         }
 
         /* Broadcast the value from rank 0 to all processes */
-        MPI_Bcast(&value, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        collBcast(&value, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
         /* Each process prints its rank and the received value */
         if (value >= 0) {
@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+# Benchmark script for the ring broadcast (Exercise 3 extension)
+# Usage: bash benchmark.sh [max_bytes]
+set -euo pipefail
+
+EXE="./ring_bcast"
+MAX_BYTES="${1:-1073741824}"
+
+# Compile
+mpicc -O2 -o ring_bcast ring_bcast.c
+
+# Clear previous results
+rm -f bcast.csv
+echo "bytes,P,algorithm,seg,time,bandwidth_MBs" > bcast.csv
+
+PROCS=(2 4 8)
+SEGMENTS=(8192 65536 524288)
+
+for P in "${PROCS[@]}"; do
+    for SEG in "${SEGMENTS[@]}"; do
+        echo "Running: P=$P  seg=$SEG"
+        mpirun --oversubscribe -np "$P" "$EXE" --max-bytes "$MAX_BYTES" --seg "$SEG"
+    done
+done
+
+echo ""
+echo "Results saved to bcast.csv"
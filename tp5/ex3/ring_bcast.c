@@ -0,0 +1,275 @@
+/*
+ * TP5 - Exercise 3 (extension): Ring Broadcast of Large Messages
+ *
+ * The ring of ex3 forwards one int, so each link is busy only while the
+ * value crosses it. For a large message the chain is pipelined instead:
+ * the message is cut into segments and rank k forwards segment s to rank
+ * k+1 while receiving segment s+1 from rank k-1, so after the first P-1
+ * segments every link carries data at the same time. Time is about
+ * (P - 1 + n/seg) * T(seg) instead of (P - 1) * T(n).
+ *
+ * Broadcasts compared for message sizes from 8 B to --max-bytes:
+ *   mpi        MPI_Bcast (whatever the library picks)
+ *   binomial   binomial tree, whole message per edge: log2(P) * T(n)
+ *   scatter    binomial scatter of P blocks + ring allgather (van de Geijn):
+ *              about 2 * T(n) for large n
+ *   ring       segmented pipelined chain, segment size --seg
+ * All are built on MPI_Send/MPI_Recv except mpi. The time of one broadcast
+ * is the max over ranks of the average over the repetitions. Every
+ * algorithm is checked once per size against the root's pattern.
+ * Results are appended to bcast.csv.
+ *
+ * Compile: mpicc -O2 -o ring_bcast ring_bcast.c
+ * Run:     mpirun -np 4 ./ring_bcast [--max-bytes B] [--seg B] [--root R]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#define MIN_BYTES 8
+#define DEFAULT_MAX_BYTES (1L << 30)
+#define DEFAULT_SEG (64L * 1024)
+#define SIZE_STEP 2          /* message sizes 8, 16, 32, ... */
+#define SEND_WINDOW 4        /* outstanding forwards in the ring */
+#define REP_BYTES (256L << 20) /* repetitions: about this many bytes per size */
+#define MAX_REPS 1000
+#define MIN_REPS 3
+
+enum { A_MPI, A_BINOMIAL, A_SCATTER, A_RING, NALGOS };
+static const char *algo_names[NALGOS] = { "mpi", "binomial", "scatter", "ring" };
+
+/* Byte i of the root's message */
+static unsigned char pattern(long i) {
+    return (unsigned char)((i * 131 + 7) & 0xff);
+}
+
+/* Binomial tree over ranks relative to root, whole message per edge */
+void bcastBinomial(unsigned char *buf, long n, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+
+    /* Receive from the parent: vr with its lowest set bit cleared */
+    int mask = 1;
+    while (mask < size) {
+        if (vr & mask) {
+            int parent = (vr - mask + root) % size;
+            MPI_Recv(buf, (int)n, MPI_BYTE, parent, 0, comm, MPI_STATUS_IGNORE);
+            break;
+        }
+        mask <<= 1;
+    }
+
+    /* Send to the children vr + mask for every lower bit */
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (vr + mask < size) {
+            int child = (vr + mask + root) % size;
+            MPI_Send(buf, (int)n, MPI_BYTE, child, 0, comm);
+        }
+    }
+}
+
+/* Offset of block b when n bytes are split into size blocks */
+static long blockOffset(long n, int size, int b) {
+    long base = n / size, rem = n % size;
+    return b * base + (b < rem ? b : rem);
+}
+
+/* Binomial scatter of the P blocks, then ring allgather. Blocks are indexed
+ * by relative rank, so each subtree's blocks are contiguous in buf. */
+void bcastScatterAllgather(unsigned char *buf, long n, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+
+    /* Scatter: receive blocks [vr, vr + mask) from the parent */
+    int mask = 1;
+    while (mask < size) {
+        if (vr & mask) {
+            int last = vr + mask < size ? vr + mask : size;
+            long off = blockOffset(n, size, vr);
+            long len = blockOffset(n, size, last) - off;
+            int parent = (vr - mask + root) % size;
+            MPI_Recv(buf + off, (int)len, MPI_BYTE, parent, 1, comm, MPI_STATUS_IGNORE);
+            break;
+        }
+        mask <<= 1;
+    }
+
+    /* ... and pass blocks [vr + mask, vr + 2 mask) to each child */
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (vr + mask < size) {
+            int last = vr + 2 * mask < size ? vr + 2 * mask : size;
+            long off = blockOffset(n, size, vr + mask);
+            long len = blockOffset(n, size, last) - off;
+            int child = (vr + mask + root) % size;
+            MPI_Send(buf + off, (int)len, MPI_BYTE, child, 1, comm);
+        }
+    }
+
+    /* Allgather: at step s send block vr - s right, receive vr - s - 1 from left */
+    int right = (rank + 1) % size, left = (rank - 1 + size) % size;
+    for (int s = 0; s < size - 1; s++) {
+        int sb = (vr - s + size) % size, rb = (vr - s - 1 + size) % size;
+        long soff = blockOffset(n, size, sb), roff = blockOffset(n, size, rb);
+        MPI_Sendrecv(buf + soff, (int)(blockOffset(n, size, sb + 1) - soff), MPI_BYTE, right, 2,
+                     buf + roff, (int)(blockOffset(n, size, rb + 1) - roff), MPI_BYTE, left, 2,
+                     comm, MPI_STATUS_IGNORE);
+    }
+}
+
+/* Pipelined chain root -> root+1 -> ... -> root-1. The receive of segment
+ * s+1 is posted before segment s is forwarded; at most SEND_WINDOW
+ * forwards are in flight. */
+void bcastRing(unsigned char *buf, long n, long seg, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int vr = (rank - root + size) % size;
+    int prev = (rank - 1 + size) % size, next = (rank + 1) % size;
+    int has_prev = vr > 0, has_next = vr < size - 1;
+
+    long nseg = (n + seg - 1) / seg;
+    MPI_Request recv_req = MPI_REQUEST_NULL;
+    MPI_Request send_req[SEND_WINDOW];
+    for (int w = 0; w < SEND_WINDOW; w++) send_req[w] = MPI_REQUEST_NULL;
+
+    if (has_prev && nseg > 0)
+        MPI_Irecv(buf, (int)(seg < n ? seg : n), MPI_BYTE, prev, 3, comm, &recv_req);
+
+    for (long s = 0; s < nseg; s++) {
+        long off = s * seg;
+        long len = off + seg < n ? seg : n - off;
+
+        if (has_prev) {
+            MPI_Wait(&recv_req, MPI_STATUS_IGNORE);
+            if (s + 1 < nseg) {
+                long noff = off + seg;
+                long nlen = noff + seg < n ? seg : n - noff;
+                MPI_Irecv(buf + noff, (int)nlen, MPI_BYTE, prev, 3, comm, &recv_req);
+            }
+        }
+        if (has_next) {
+            MPI_Request *slot = &send_req[s % SEND_WINDOW];
+            MPI_Wait(slot, MPI_STATUS_IGNORE);
+            MPI_Isend(buf + off, (int)len, MPI_BYTE, next, 3, comm, slot);
+        }
+    }
+    MPI_Waitall(SEND_WINDOW, send_req, MPI_STATUSES_IGNORE);
+}
+
+void runBcast(int algo, unsigned char *buf, long n, long seg, int root, MPI_Comm comm) {
+    switch (algo) {
+    case A_MPI:      MPI_Bcast(buf, (int)n, MPI_BYTE, root, comm); break;
+    case A_BINOMIAL: bcastBinomial(buf, n, root, comm); break;
+    case A_SCATTER:  bcastScatterAllgather(buf, n, root, comm); break;
+    case A_RING:     bcastRing(buf, n, seg, root, comm); break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long max_bytes = DEFAULT_MAX_BYTES;
+    long seg = DEFAULT_SEG;
+    int root = 0;
+    int rank, size;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--max-bytes") == 0 && a + 1 < argc) {
+            max_bytes = atol(argv[++a]);
+        } else if (strcmp(argv[a], "--seg") == 0 && a + 1 < argc) {
+            seg = atol(argv[++a]);
+        } else if (strcmp(argv[a], "--root") == 0 && a + 1 < argc) {
+            root = atoi(argv[++a]);
+        } else {
+            if (rank == 0)
+                printf("Usage: %s [--max-bytes B] [--seg B] [--root R]\n", argv[0]);
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    if (max_bytes < MIN_BYTES || seg <= 0 || root < 0 || root >= size) {
+        if (rank == 0)
+            fprintf(stderr, "Error: need --max-bytes >= %d, --seg > 0, 0 <= root < P\n", MIN_BYTES);
+        MPI_Finalize();
+        return 1;
+    }
+
+    unsigned char *buf = malloc(max_bytes);
+    if (!buf) {
+        fprintf(stderr, "Rank %d: cannot allocate %ld bytes\n", rank, max_bytes);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (rank == 0) {
+        printf("Broadcast of 8 B .. %ld B, P=%d, root=%d, ring segment=%ld B\n",
+               max_bytes, size, root, seg);
+        printf("%12s", "bytes");
+        for (int a = 0; a < NALGOS; a++) printf(" %12s", algo_names[a]);
+        printf("   (us per broadcast; MB/s of the best)\n");
+    }
+
+    FILE *f = NULL;
+    if (rank == 0) f = fopen("bcast.csv", "a");
+
+    for (long n = MIN_BYTES; n <= max_bytes; n *= SIZE_STEP) {
+        int reps = (int)(REP_BYTES / n);
+        if (reps > MAX_REPS) reps = MAX_REPS;
+        if (reps < MIN_REPS) reps = MIN_REPS;
+
+        double t[NALGOS];
+        int best = 0;
+        for (int algo = 0; algo < NALGOS; algo++) {
+            /* Correctness: non-roots start from zeros */
+            if (rank == root)
+                for (long i = 0; i < n; i++) buf[i] = pattern(i);
+            else
+                memset(buf, 0, n);
+            runBcast(algo, buf, n, seg, root, MPI_COMM_WORLD);
+            long bad = 0, total_bad = 0;
+            for (long i = 0; i < n; i++) bad += buf[i] != pattern(i);
+            MPI_Allreduce(&bad, &total_bad, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+            if (total_bad != 0) {
+                if (rank == 0)
+                    fprintf(stderr, "Error: %s broadcast of %ld bytes: %ld wrong bytes\n",
+                            algo_names[algo], n, total_bad);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+
+            double elapsed = 0.0;
+            for (int r = 0; r < reps; r++) {
+                MPI_Barrier(MPI_COMM_WORLD);
+                double t0 = MPI_Wtime();
+                runBcast(algo, buf, n, seg, root, MPI_COMM_WORLD);
+                elapsed += MPI_Wtime() - t0;
+            }
+            elapsed /= reps;
+            MPI_Reduce(&elapsed, &t[algo], 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+            if (rank == 0 && t[algo] < t[best]) best = algo;
+        }
+
+        if (rank == 0) {
+            printf("%12ld", n);
+            for (int a = 0; a < NALGOS; a++) printf(" %12.2f", t[a] * 1e6);
+            printf("   %s %.1f\n", algo_names[best], n / t[best] / 1e6);
+            if (f) {
+                for (int a = 0; a < NALGOS; a++)
+                    fprintf(f, "%ld,%d,%s,%ld,%.12e,%.6f\n", n, size, algo_names[a],
+                            a == A_RING ? seg : 0L, t[a], n / t[a] / 1e6);
+            }
+        }
+        if (n > max_bytes / SIZE_STEP) break;
+    }
+
+    if (f) fclose(f);
+    free(buf);
+    MPI_Finalize();
+    return 0;
+}
@@ -6,22 +6,59 @@ set -euo pipefail
 EXE="./ex4"
 
 # Compile
-mpicc -O2 -o ex4 ex4.c -lm
+mpicc -O2 -fopenmp -o ex4 ex4.c -lm
 
 # Clear previous results
-rm -f timings.csv
-echo "N,P,t_serial,t_parallel,speedup,efficiency,max_error" > timings.csv
+rm -f timings.csv iterative.csv
+echo "N,P,t_serial,t_parallel,speedup,efficiency,max_error,storage,mode,threads" > timings.csv
+echo "N,P,threads,storage,iters,t_blocking,t_overlap,t_comm,hidden,max_diff" > iterative.csv
 
 SIZES=(64 128 256 512 1024 2048)
 PROCS=(1 2 4 8)
+STORAGE=(double float bf16 fp16)
+
+export OMP_NUM_THREADS=1
 
 for N in "${SIZES[@]}"; do
     for P in "${PROCS[@]}"; do
-        echo "Running: N=$N  P=$P"
-        mpirun --oversubscribe -np "$P" "$EXE" "$N"
+        for S in "${STORAGE[@]}"; do
+            echo "Running: N=$N  P=$P  storage=$S"
+            mpirun --oversubscribe -np "$P" "$EXE" "$N" "$S"
+        done
+        echo "Running: N=$N  P=$P  distributed generation"
+        mpirun --oversubscribe -np "$P" "$EXE" "$N" --distributed
+        echo "Running: N=$N  P=$P  1D vs 2D decomposition"
+        mpirun --oversubscribe -np "$P" "$EXE" "$N" --2d
+        echo "Running: N=$N  P=$P  repeated matvec, overlapped allgather"
+        mpirun --oversubscribe -np "$P" "$EXE" "$N" --iters 50
+    done
+done
+
+# Pipelined distribution: chunk size sweep
+PIPE_N=4096
+for P in "${PROCS[@]}"; do
+    for C in 16 64 256 1024; do
+        echo "Running: N=$PIPE_N  P=$P  chunk=$C rows"
+        mpirun --oversubscribe -np "$P" "$EXE" "$PIPE_N" --chunk "$C"
+    done
+done
+
+# Hybrid sweep: ranks x threads up to 8 cores. Scatter mode pays the
+# Scatterv/Bcast fan-out that fewer, wider ranks cut; distributed mode has
+# no distribution and isolates the compute side.
+HYBRID_N=4096
+for P in "${PROCS[@]}"; do
+    for T in 1 2 4 8; do
+        if (( P * T > 8 )); then continue; fi
+        echo "Running: N=$HYBRID_N  P=$P  threads=$T  scatter and distributed"
+        OMP_NUM_THREADS=$T mpirun --oversubscribe --bind-to none -x OMP_NUM_THREADS \
+            -np "$P" "$EXE" "$HYBRID_N"
+        OMP_NUM_THREADS=$T mpirun --oversubscribe --bind-to none -x OMP_NUM_THREADS \
+            -np "$P" "$EXE" "$HYBRID_N" --distributed
     done
 done
 
 echo ""
-echo "Results saved to timings.csv"
+echo "Results saved to timings.csv and iterative.csv"
 cat timings.csv
+cat iterative.csv
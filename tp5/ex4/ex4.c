@@ -9,14 +9,125 @@
  * - Results are gathered via MPI_Gatherv.
  * - Speedup / efficiency are reported and appended to timings.csv.
  *
- * Compile: mpicc -O2 -o ex4 ex4.c -lm
- * Run:     mpirun -np 4 ./ex4 1000
+ * Optional storage format for A: double (default), float, bf16 or fp16.
+ * Root compresses A before the scatter, so both the scattered bytes and the
+ * bytes streamed by the local product shrink by 2x or 4x. Elements are
+ * widened on the fly and accumulated in double; the error against the
+ * double serial result is reported.
+ *
+ * A and b come from a counter-based generator: every entry is a function of
+ * its global index only. With --distributed each rank generates its own row
+ * block and b, so A is never materialized on root and nothing is scattered
+ * or broadcast; root computes the serial reference block by block. N can
+ * then grow with the number of ranks.
+ *
+ * With --2d the ranks form a pr x pc grid and each holds one block of A and
+ * only the matching segment of b (see run2D). Both the 2D scheme and the 1D
+ * scheme with b broadcast in full are timed on resident, locally generated
+ * matrices, and the communication volume per rank is reported.
+ *
+ * With --chunk R root sends every rank its rows in chunks of R rows with
+ * nonblocking point-to-point, issued round-robin over the ranks, and each
+ * rank multiplies chunk k while chunks k+1.. are still in flight, calling
+ * MPI_Testall between row blocks so that the transfers progress.
+ *
+ * With --iters K the product is applied K times to a resident, locally
+ * generated A, power-iteration style (see runIterative): only the vector
+ * is exchanged each step, with MPI_Iallgatherv overlapped with the product
+ * on the locally owned columns. Results go to iterative.csv.
+ *
+ * Hybrid: every local product runs on OpenMP threads over the rows of the
+ * block (MPI_THREAD_FUNNELED: only the master thread calls MPI), with a
+ * SIMD dot product over DOT_LANES independent accumulators. One rank per
+ * socket with one thread per core cuts the broadcast/scatter fan-out.
+ * Efficiency is computed over ranks x threads.
+ *
+ * Compile: mpicc -O2 -fopenmp -o ex4 ex4.c -lm
+ * Run:     OMP_NUM_THREADS=2 mpirun -np 4 ./ex4 1000 [double|float|bf16|fp16] [--distributed | --2d | --iters K | --chunk R]
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <math.h>
 #include <mpi.h>
+#include <omp.h>
+
+/* Storage formats for A */
+enum { ST_DOUBLE, ST_FLOAT, ST_BF16, ST_FP16, NSTORAGE };
+static const char *storage_names[NSTORAGE] = { "double", "float", "bf16", "fp16" };
+static const int storage_bytes[NSTORAGE] = { 8, 4, 2, 2 };
+
+/* Generator streams: one per kind of random entry */
+#define SEED 42
+enum { STREAM_ROW0, STREAM_DIAG, STREAM_B };
+
+/* Rows of A generated per block by the serial reference in --distributed */
+#define VERIFY_BLOCK_ELEMS (1 << 22)
+
+/* Timed repetitions of each scheme in --2d (best is kept) */
+#define REPS_2D 10
+
+/* Rows of the overlapped product between MPI_Test calls in --iters and
+ * --chunk */
+#define PROGRESS_ROWS 64
+
+/* Tag of every --chunk message; pairwise ordering matches the chunks */
+#define CHUNK_TAG 0
+
+/* Independent partial sums per dot product (a multiple of the SIMD width) */
+#define DOT_LANES 16
+
+/* OpenMP threads per rank, set once in main */
+static int num_threads = 1;
+
+/* splitmix64 finalizer */
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform double in [0, 1) depending only on (stream, counter) */
+double counterUniform(uint64_t stream, uint64_t counter) {
+    uint64_t key = mix64(SEED + 0x9e3779b97f4a7c15ULL * (stream + 1));
+    return (mix64(key + counter) >> 11) * 0x1p-53;
+}
+
+/* Block A[row0:row0+rows, col0:col0+cols] (row-major, stride cols), same
+ * pattern as the assignment: A[0][:100] random, A[1][100:200] = A[0][:100],
+ * random diagonal. */
+void generateBlock(double *A_blk, int row0, int rows, int col0, int cols, int N) {
+    int limit = (N < 100) ? N : 100;
+    int copy_len = (N - 100 < 100) ? (N - 100) : 100;
+    int col1 = col0 + cols;
+
+    for (int i = 0; i < rows; ++i) {
+        int gi = row0 + i;
+        double *row = A_blk + (size_t)i * cols - col0;   /* indexed by global column */
+        for (int j = col0; j < col1; ++j) row[j] = 0.0;
+
+        if (gi == 0)
+            for (int j = col0; j < col1 && j < limit; ++j)
+                row[j] = counterUniform(STREAM_ROW0, j);
+        if (gi == 1)
+            for (int j = (col0 > 100 ? col0 : 100); j < col1 && j < 100 + copy_len; ++j)
+                row[j] = counterUniform(STREAM_ROW0, j - 100);
+        if (gi >= col0 && gi < col1)
+            row[gi] = counterUniform(STREAM_DIAG, gi);
+    }
+}
+
+/* Full rows [row0, row0 + rows) of A */
+void generateRows(double *A_rows, int row0, int rows, int N) {
+    generateBlock(A_rows, row0, rows, 0, N, N);
+}
+
+void generateVector(double *b, int N) {
+    for (int i = 0; i < N; ++i)
+        b[i] = counterUniform(STREAM_B, i);
+}
 
 /* Serial matrix-vector multiplication */
 void matrixVectorMult(double *A, double *b, double *x, int rows, int N) {
@@ -28,19 +139,552 @@ void matrixVectorMult(double *A, double *b, double *x, int rows, int N) {
     }
 }
 
+static inline float bitsToFloat(uint32_t x) {
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+static inline uint32_t floatToBits(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    return x;
+}
+
+/* bfloat16: upper half of a float, round-to-nearest-even */
+static uint16_t floatToBf16(float f) {
+    uint32_t x = floatToBits(f);
+    return (uint16_t)((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+static inline float bf16ToFloat(uint16_t h) {
+    return bitsToFloat((uint32_t)h << 16);
+}
+
+/* IEEE fp16, round-to-nearest-even; overflow saturates to infinity */
+static uint16_t floatToFp16(float f) {
+    uint32_t x = floatToBits(f);
+    uint16_t sign = (x >> 16) & 0x8000;
+    uint32_t ax = x & 0x7fffffff;
+    float a = bitsToFloat(ax);
+    if (a >= 65520.0f) return sign | 0x7c00;
+    if (a < 0x1p-14f) return sign | (uint16_t)lrintf(a * 0x1p24f);  /* subnormal */
+    ax += 0xfff + ((ax >> 13) & 1);
+    return sign | (uint16_t)((ax >> 13) - (112 << 10));   /* rebias 127 -> 15 */
+}
+
+/* Integer-only decode (vectorizes without F16C); covers subnormals */
+static inline float fp16ToFloat(uint16_t h) {
+    float a = bitsToFloat((uint32_t)(h & 0x7fff) << 13) * 0x1p112f;
+    return bitsToFloat(floatToBits(a) | (uint32_t)(h & 0x8000) << 16);
+}
+
+/* Convert count doubles into the storage format */
+void compressMatrix(const double *A, void *out, size_t count, int storage) {
+    for (size_t i = 0; i < count; ++i) {
+        switch (storage) {
+        case ST_DOUBLE: ((double *)out)[i] = A[i]; break;
+        case ST_FLOAT:  ((float *)out)[i] = (float)A[i]; break;
+        case ST_BF16:   ((uint16_t *)out)[i] = floatToBf16((float)A[i]); break;
+        case ST_FP16:   ((uint16_t *)out)[i] = floatToFp16((float)A[i]); break;
+        }
+    }
+}
+
+/* Matrix-vector multiplication on a compressed matrix, double accumulators */
+/*
+ * Dot products of one stored row segment with b, DOT_LANES partial sums:
+ * the lanes vectorize and break the dependency chain of a single sum.
+ */
+static inline double dotDouble(const double *a, const double *b, int len) {
+    double acc[DOT_LANES] = {0.0};
+    int full = len / DOT_LANES * DOT_LANES;
+    for (int j = 0; j < full; j += DOT_LANES) {
+        #pragma omp simd
+        for (int l = 0; l < DOT_LANES; ++l) acc[l] += a[j + l] * b[j + l];
+    }
+    double s = 0.0;
+    for (int j = full; j < len; ++j) s += a[j] * b[j];
+    for (int l = 0; l < DOT_LANES; ++l) s += acc[l];
+    return s;
+}
+
+static inline double dotFloat(const float *a, const double *b, int len) {
+    double acc[DOT_LANES] = {0.0};
+    int full = len / DOT_LANES * DOT_LANES;
+    for (int j = 0; j < full; j += DOT_LANES) {
+        #pragma omp simd
+        for (int l = 0; l < DOT_LANES; ++l) acc[l] += (double)a[j + l] * b[j + l];
+    }
+    double s = 0.0;
+    for (int j = full; j < len; ++j) s += (double)a[j] * b[j];
+    for (int l = 0; l < DOT_LANES; ++l) s += acc[l];
+    return s;
+}
+
+static inline double dotBf16(const uint16_t *a, const double *b, int len) {
+    double acc[DOT_LANES] = {0.0};
+    int full = len / DOT_LANES * DOT_LANES;
+    for (int j = 0; j < full; j += DOT_LANES) {
+        #pragma omp simd
+        for (int l = 0; l < DOT_LANES; ++l) acc[l] += (double)bf16ToFloat(a[j + l]) * b[j + l];
+    }
+    double s = 0.0;
+    for (int j = full; j < len; ++j) s += (double)bf16ToFloat(a[j]) * b[j];
+    for (int l = 0; l < DOT_LANES; ++l) s += acc[l];
+    return s;
+}
+
+static inline double dotFp16(const uint16_t *a, const double *b, int len) {
+    double acc[DOT_LANES] = {0.0};
+    int full = len / DOT_LANES * DOT_LANES;
+    for (int j = 0; j < full; j += DOT_LANES) {
+        #pragma omp simd
+        for (int l = 0; l < DOT_LANES; ++l) acc[l] += (double)fp16ToFloat(a[j + l]) * b[j + l];
+    }
+    double s = 0.0;
+    for (int j = full; j < len; ++j) s += (double)fp16ToFloat(a[j]) * b[j];
+    for (int l = 0; l < DOT_LANES; ++l) s += acc[l];
+    return s;
+}
+
+/* x[i] += A[i][col0:col1] . b_seg for rows i < rows; b_seg[0] is b[col0].
+ * Rows are shared among the OpenMP threads of the rank. */
+void matrixVectorMultRange(const void *A, const double *b_seg, double *x,
+                           int rows, int N, int col0, int col1, int storage) {
+    int len = col1 - col0;
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        size_t start = (size_t)i * N + col0;
+        double s;
+        if (storage == ST_DOUBLE)
+            s = dotDouble((const double *)A + start, b_seg, len);
+        else if (storage == ST_FLOAT)
+            s = dotFloat((const float *)A + start, b_seg, len);
+        else if (storage == ST_BF16)
+            s = dotBf16((const uint16_t *)A + start, b_seg, len);
+        else
+            s = dotFp16((const uint16_t *)A + start, b_seg, len);
+        x[i] += s;
+    }
+}
+
+void matrixVectorMultStored(const void *A, const double *b, double *x,
+                            int rows, int N, int storage) {
+    for (int i = 0; i < rows; ++i) x[i] = 0.0;
+    matrixVectorMultRange(A, b, x, rows, N, 0, N, storage);
+}
+
+/* Serial reference without the full matrix: A is generated a block of rows
+ * at a time. Returns the time spent in the products only. */
+double matrixVectorMultBlockwise(const double *b, double *x, int N) {
+    int block = VERIFY_BLOCK_ELEMS / N > 0 ? VERIFY_BLOCK_ELEMS / N : 1;
+    if (block > N) block = N;
+    double *A_block = (double *)malloc((size_t)block * N * sizeof(double));
+    if (!A_block) {
+        fprintf(stderr, "Memory allocation failed on root.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    double t = 0.0;
+    for (int row0 = 0; row0 < N; row0 += block) {
+        int rows = (N - row0 < block) ? (N - row0) : block;
+        generateRows(A_block, row0, rows, N);
+        double t0 = MPI_Wtime();
+        matrixVectorMult(A_block, (double *)b, x + row0, rows, N);
+        t += MPI_Wtime() - t0;
+    }
+    free(A_block);
+    return t;
+}
+
+/* Part p of n items split into parts pieces, the first n % parts one larger */
+static void splitRange(int n, int parts, int p, int *start, int *len) {
+    int base = n / parts, rem = n % parts;
+    *len   = base + (p < rem ? 1 : 0);
+    *start = p * base + (p < rem ? p : rem);
+}
+
+/* Generate block A[row0:+rows, col0:+cols] in the storage format */
+static void *generateStoredBlock(int row0, int rows, int col0, int cols, int N,
+                                 int storage, int rank) {
+    void *A_blk = malloc((size_t)rows * cols * storage_bytes[storage] + 1);
+    double *row = (double *)malloc((size_t)cols * sizeof(double) + 1);
+    if (!A_blk || !row) {
+        fprintf(stderr, "Rank %d: failed to allocate matrix block\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int i = 0; i < rows; ++i) {
+        generateBlock(row, row0 + i, 1, col0, cols, N);
+        compressMatrix(row, (char *)A_blk + (size_t)i * cols * storage_bytes[storage],
+                       cols, storage);
+    }
+    free(row);
+    return A_blk;
+}
+
+/* Max |x - ref| over N entries */
+static double maxError(const double *x, const double *ref, int N) {
+    double max_error = 0.0;
+    for (int i = 0; i < N; ++i)
+        if (fabs(x[i] - ref[i]) > max_error) max_error = fabs(x[i] - ref[i]);
+    return max_error;
+}
+
+/*
+ * 1D vs 2D decomposition with A resident on every rank.
+ *
+ * 1D: rank r owns a block of full rows; b (N values) is broadcast from root
+ *     and the row results are gathered.
+ * 2D: ranks form a pr x pc grid (MPI_Dims_create); rank (i, j) owns block
+ *     A[rows_i, cols_j] and needs only b[cols_j]:
+ *       b[cols_j]  Scatterv along grid row 0, then Bcast down grid column j
+ *       partial    y_i += A_ij * b_j
+ *       y_i        Reduce along grid row i onto grid column 0
+ *       y          Gatherv of the y_i down grid column 0 onto root
+ *     so a rank moves about N/pc + N/pr values instead of N.
+ *
+ * Communication volume is the payload each rank sends or receives itself
+ * (collective forwarding inside MPI is not counted).
+ */
+int run2D(int N, int storage, int rank, int world_size) {
+    int dims[2] = {0, 0}, periods[2] = {0, 0}, coords[2];
+    MPI_Dims_create(world_size, 2, dims);
+    MPI_Comm grid, row_comm, col_comm;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid);  /* no reorder: root stays (0,0) */
+    MPI_Cart_coords(grid, rank, 2, coords);
+    int keep_cols[2] = {0, 1}, keep_rows[2] = {1, 0};
+    MPI_Cart_sub(grid, keep_cols, &row_comm);   /* my grid row, ranked by column */
+    MPI_Cart_sub(grid, keep_rows, &col_comm);   /* my grid column, ranked by row */
+    int pr = dims[0], pc = dims[1], gi = coords[0], gj = coords[1];
+
+    /* ---- Root: b and the blockwise serial reference ---- */
+    double *b = (double *)malloc(N * sizeof(double));
+    double *x_serial = NULL, *x_parallel = NULL;
+    double t_serial = 0.0;
+    if (!b) {
+        fprintf(stderr, "Rank %d: failed to allocate b\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (rank == 0) {
+        x_serial   = (double *)malloc(N * sizeof(double));
+        x_parallel = (double *)malloc(N * sizeof(double));
+        if (!x_serial || !x_parallel) {
+            fprintf(stderr, "Memory allocation failed on root.\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        generateVector(b, N);
+        t_serial = matrixVectorMultBlockwise(b, x_serial, N);
+    }
+
+    /* ---- 1D layout ---- */
+    int *counts1 = (int *)malloc(world_size * sizeof(int));
+    int *displs1 = (int *)malloc(world_size * sizeof(int));
+    for (int r = 0; r < world_size; ++r)
+        splitRange(N, world_size, r, &displs1[r], &counts1[r]);
+    int row0 = displs1[rank], rows = counts1[rank];
+    void *A1 = generateStoredBlock(row0, rows, 0, N, N, storage, rank);
+    double *y1 = (double *)malloc((size_t)rows * sizeof(double) + 1);
+
+    /* ---- 2D layout ---- */
+    int *counts_r = (int *)malloc(pr * sizeof(int));
+    int *displs_r = (int *)malloc(pr * sizeof(int));
+    int *counts_c = (int *)malloc(pc * sizeof(int));
+    int *displs_c = (int *)malloc(pc * sizeof(int));
+    for (int i = 0; i < pr; ++i) splitRange(N, pr, i, &displs_r[i], &counts_r[i]);
+    for (int j = 0; j < pc; ++j) splitRange(N, pc, j, &displs_c[j], &counts_c[j]);
+    int nr = counts_r[gi], nc = counts_c[gj];
+    void *A2 = generateStoredBlock(displs_r[gi], nr, displs_c[gj], nc, N, storage, rank);
+    double *b_j    = (double *)malloc((size_t)nc * sizeof(double) + 1);
+    double *y_part = (double *)malloc((size_t)nr * sizeof(double) + 1);
+    double *y_i    = (double *)malloc((size_t)nr * sizeof(double) + 1);
+
+    if (!counts1 || !displs1 || !y1 || !counts_r || !displs_r || !counts_c || !displs_c ||
+        !b_j || !y_part || !y_i) {
+        fprintf(stderr, "Rank %d: allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    /* Per-rank communication volume in bytes */
+    double bytes1 = rank == 0 ? 0.0 : (double)(N + rows) * sizeof(double);
+    double bytes2 = 0.0;
+    if (gi == 0 && gj != 0) bytes2 += nc;   /* b segment from the row-0 scatter */
+    if (gi != 0)            bytes2 += nc;   /* b segment from the column bcast */
+    if (gj != 0)            bytes2 += nr;   /* partial y into the row reduce */
+    if (gj == 0 && gi != 0) bytes2 += nr;   /* y_i into the column gather */
+    bytes2 *= sizeof(double);
+
+    double best1 = 1e30, best2 = 1e30;
+    for (int rep = 0; rep < REPS_2D; ++rep) {
+        double t, tmax;
+
+        /* 1D: full broadcast of b */
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = MPI_Wtime();
+        MPI_Bcast(b, N, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        matrixVectorMultStored(A1, b, y1, rows, N, storage);
+        MPI_Gatherv(y1, rows, MPI_DOUBLE, x_parallel, counts1, displs1, MPI_DOUBLE,
+                    0, MPI_COMM_WORLD);
+        t = MPI_Wtime() - t;
+        MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        if (rank == 0 && tmax < best1) best1 = tmax;
+    }
+    double err1 = rank == 0 ? maxError(x_parallel, x_serial, N) : 0.0;
+
+    for (int rep = 0; rep < REPS_2D; ++rep) {
+        double t, tmax;
+
+        /* 2D: b segments down the grid columns, partial results along the rows */
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = MPI_Wtime();
+        if (gi == 0)
+            MPI_Scatterv(b, counts_c, displs_c, MPI_DOUBLE, b_j, nc, MPI_DOUBLE, 0, row_comm);
+        MPI_Bcast(b_j, nc, MPI_DOUBLE, 0, col_comm);
+        matrixVectorMultStored(A2, b_j, y_part, nr, nc, storage);
+        MPI_Reduce(y_part, y_i, nr, MPI_DOUBLE, MPI_SUM, 0, row_comm);
+        if (gj == 0)
+            MPI_Gatherv(y_i, nr, MPI_DOUBLE, x_parallel, counts_r, displs_r, MPI_DOUBLE,
+                        0, col_comm);
+        t = MPI_Wtime() - t;
+        MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        if (rank == 0 && tmax < best2) best2 = tmax;
+    }
+    double err2 = rank == 0 ? maxError(x_parallel, x_serial, N) : 0.0;
+
+    double max_bytes1, max_bytes2;
+    MPI_Reduce(&bytes1, &max_bytes1, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&bytes2, &max_bytes2, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        int cores = world_size * num_threads;
+        printf("N=%d P=%d T=%d storage=%s grid=%dx%d serial=%.6e\n",
+               N, world_size, num_threads, storage_names[storage], pr, pc, t_serial);
+        printf("  %-4s %6s %14s %10s %16s %12s\n",
+               "", "grid", "parallel (s)", "speedup", "max bytes/rank", "max_error");
+        printf("  %-4s %3dx%-2d %14.6e %10.4f %16.0f %12e\n",
+               "1D", world_size, 1, best1, t_serial / best1, max_bytes1, err1);
+        printf("  %-4s %3dx%-2d %14.6e %10.4f %16.0f %12e\n",
+               "2D", pr, pc, best2, t_serial / best2, max_bytes2, err2);
+
+        FILE *f = fopen("timings.csv", "a");
+        if (f) {
+            fprintf(f, "%d,%d,%.12e,%.12e,%.6f,%.6f,%e,%s,%s,%d\n",
+                    N, world_size, t_serial, best1, t_serial / best1,
+                    t_serial / best1 / cores, err1, storage_names[storage], "1d-resident",
+                    num_threads);
+            fprintf(f, "%d,%d,%.12e,%.12e,%.6f,%.6f,%e,%s,%s,%d\n",
+                    N, world_size, t_serial, best2, t_serial / best2,
+                    t_serial / best2 / cores, err2, storage_names[storage], "2d", num_threads);
+            fclose(f);
+        }
+    }
+
+    free(A1); free(y1); free(counts1); free(displs1);
+    free(A2); free(b_j); free(y_part); free(y_i);
+    free(counts_r); free(displs_r); free(counts_c); free(displs_c);
+    free(b);
+    if (x_serial)   free(x_serial);
+    if (x_parallel) free(x_parallel);
+    MPI_Comm_free(&row_comm);
+    MPI_Comm_free(&col_comm);
+    MPI_Comm_free(&grid);
+    return 0;
+}
+
+/* Euclidean norm of v[0:N] */
+static double norm2(const double *v, int N) {
+    double s = 0.0;
+    for (int i = 0; i < N; ++i) s += v[i] * v[i];
+    return sqrt(s);
+}
+
+/*
+ * Power iteration with A resident: v_{k+1} = A v_k / ||v_k||. Each rank owns
+ * a row block of A and the matching segment of v; every step all-gathers
+ * the segments into the full vector.
+ *
+ *   blocking: MPI_Allgatherv, then the whole local product
+ *   overlap:  MPI_Iallgatherv of the own segment; meanwhile the product on
+ *             the own columns (the segment is already local, calling
+ *             MPI_Test every PROGRESS_ROWS rows to drive progress); after the
+ *             wait, ||v|| and the remaining columns. The 1/||v|| scale is
+ *             linear, so it is applied at the end.
+ *
+ * Communication alone (K Allgatherv) is timed too. With the compute time
+ * t_compute = t_blocking - t_comm, the hidden fraction of the communication
+ * is 1 - (t_overlap - t_compute) / t_comm, clamped to [0, 1]; it is not
+ * defined for P = 1. Per-iteration times go to iterative.csv.
+ */
+int runIterative(int N, int storage, int iters, int rank, int world_size) {
+    int *counts = (int *)malloc(world_size * sizeof(int));
+    int *displs = (int *)malloc(world_size * sizeof(int));
+    if (!counts || !displs) {
+        fprintf(stderr, "Rank %d: allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int r = 0; r < world_size; ++r)
+        splitRange(N, world_size, r, &displs[r], &counts[r]);
+    int row0 = displs[rank], rows = counts[rank];
+
+    void *A_local = generateStoredBlock(row0, rows, 0, N, N, storage, rank);
+    double *v     = (double *)malloc(N * sizeof(double));
+    double *b0    = (double *)malloc(N * sizeof(double));
+    double *y_own = (double *)malloc((size_t)rows * sizeof(double) + 1);
+    double *y_new = (double *)malloc((size_t)rows * sizeof(double) + 1);
+    double *y_blocking = (double *)malloc((size_t)rows * sizeof(double) + 1);
+    if (!v || !b0 || !y_own || !y_new || !y_blocking) {
+        fprintf(stderr, "Rank %d: allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    generateVector(b0, N);
+
+    double t_variant[2], lambda[2];
+    for (int variant = 0; variant < 2; ++variant) {
+        for (int i = 0; i < rows; ++i) y_own[i] = b0[row0 + i];
+        double nrm = 0.0;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double t0 = MPI_Wtime();
+        for (int it = 0; it < iters; ++it) {
+            if (variant == 0) {
+                MPI_Allgatherv(y_own, rows, MPI_DOUBLE, v, counts, displs, MPI_DOUBLE,
+                               MPI_COMM_WORLD);
+                nrm = norm2(v, N);
+                matrixVectorMultStored(A_local, v, y_new, rows, N, storage);
+            } else {
+                MPI_Request req;
+                MPI_Iallgatherv(y_own, rows, MPI_DOUBLE, v, counts, displs, MPI_DOUBLE,
+                                MPI_COMM_WORLD, &req);
+                for (int i = 0; i < rows; ++i) y_new[i] = 0.0;
+                size_t row_bytes = (size_t)N * storage_bytes[storage];
+                for (int r = 0; r < rows; r += PROGRESS_ROWS) {
+                    int len = (rows - r < PROGRESS_ROWS) ? (rows - r) : PROGRESS_ROWS;
+                    int done;
+                    matrixVectorMultRange((char *)A_local + r * row_bytes, y_own, y_new + r,
+                                          len, N, row0, row0 + rows, storage);
+                    MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+                }
+                MPI_Wait(&req, MPI_STATUS_IGNORE);
+                nrm = norm2(v, N);
+                matrixVectorMultRange(A_local, v, y_new, rows, N, 0, row0, storage);
+                matrixVectorMultRange(A_local, v + row0 + rows, y_new, rows, N,
+                                      row0 + rows, N, storage);
+            }
+            for (int i = 0; i < rows; ++i) y_new[i] /= nrm;
+            double *tmp = y_own; y_own = y_new; y_new = tmp;
+        }
+        double t = MPI_Wtime() - t0;
+        MPI_Reduce(&t, &t_variant[variant], 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        lambda[variant] = nrm;   /* ||A v|| / ||v|| -> |largest eigenvalue| */
+        if (variant == 0)
+            for (int i = 0; i < rows; ++i) y_blocking[i] = y_own[i];
+    }
+
+    /* Both variants must produce the same iterate up to summation order */
+    double diff = 0.0, max_diff;
+    for (int i = 0; i < rows; ++i)
+        if (fabs(y_own[i] - y_blocking[i]) > diff) diff = fabs(y_own[i] - y_blocking[i]);
+    MPI_Reduce(&diff, &max_diff, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /* Communication alone */
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t0 = MPI_Wtime();
+    for (int it = 0; it < iters; ++it)
+        MPI_Allgatherv(y_own, rows, MPI_DOUBLE, v, counts, displs, MPI_DOUBLE, MPI_COMM_WORLD);
+    double t = MPI_Wtime() - t0, t_comm;
+    MPI_Reduce(&t, &t_comm, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        double per_block = t_variant[0] / iters, per_overlap = t_variant[1] / iters;
+        double per_comm = t_comm / iters;
+        double t_compute = per_block - per_comm;
+        int has_comm = world_size > 1 && per_comm > 0.0;
+        double hidden = has_comm ? 1.0 - (per_overlap - t_compute) / per_comm : 0.0;
+        if (hidden < 0.0) hidden = 0.0;
+        if (hidden > 1.0) hidden = 1.0;
+        printf("N=%d P=%d T=%d storage=%s iters=%d\n",
+               N, world_size, num_threads, storage_names[storage], iters);
+        printf("  per iteration: blocking=%.6e overlap=%.6e comm only=%.6e\n",
+               per_block, per_overlap, per_comm);
+        if (has_comm)
+            printf("  communication hidden: %.1f%%\n", 100.0 * hidden);
+        else
+            printf("  communication hidden: n/a (no communication)\n");
+        printf("  lambda: blocking=%.12f overlap=%.12f, max |v diff|=%e\n",
+               lambda[0], lambda[1], max_diff);
+
+        /* Own file: these times are per iteration, not a serial/parallel pair */
+        FILE *f = fopen("iterative.csv", "a");
+        if (f) {
+            fprintf(f, "%d,%d,%d,%s,%d,%.12e,%.12e,%.12e,", N, world_size, num_threads,
+                    storage_names[storage], iters, per_block, per_overlap, per_comm);
+            if (has_comm) fprintf(f, "%.6f", hidden);
+            fprintf(f, ",%e\n", max_diff);
+            fclose(f);
+        }
+    }
+
+    free(A_local); free(v); free(b0); free(y_own); free(y_new); free(y_blocking);
+    free(counts); free(displs);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     int rank, world_size;
 
-    MPI_Init(&argc, &argv);
+    /* Threads compute, only the master thread communicates */
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    num_threads = omp_get_max_threads();
+    if (provided < MPI_THREAD_FUNNELED && num_threads > 1) {
+        if (rank == 0) printf("MPI library lacks MPI_THREAD_FUNNELED; using 1 thread.\n");
+        num_threads = 1;
+        omp_set_num_threads(1);
+    }
 
-    if (argc != 2) {
-        if (rank == 0) printf("Usage: %s <matrix_size>\n", argv[0]);
+    if (argc < 2) {
+        if (rank == 0)
+            printf("Usage: %s <matrix_size> [double|float|bf16|fp16] [--distributed | --2d | --iters K | --chunk R]\n",
+                   argv[0]);
         MPI_Finalize();
         return 1;
     }
 
+    int storage = ST_DOUBLE;
+    int distributed = 0, two_d = 0, iters = 0, chunk = 0;
+    for (int i = 2; i < argc; ++i) {
+        int s;
+        for (s = 0; s < NSTORAGE; ++s)
+            if (strcmp(argv[i], storage_names[s]) == 0) break;
+        if (s < NSTORAGE) {
+            storage = s;
+        } else if (strcmp(argv[i], "--distributed") == 0) {
+            distributed = 1;
+        } else if (strcmp(argv[i], "--2d") == 0) {
+            two_d = 1;
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunk = atoi(argv[++i]);
+        } else {
+            if (rank == 0) printf("Unknown argument '%s'.\n", argv[i]);
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    if (chunk < 0 || (chunk > 0 && distributed)) {
+        if (rank == 0) printf("--chunk takes a positive row count and needs root-held A.\n");
+        MPI_Finalize();
+        return 1;
+    }
+    char mode[32];
+    if (chunk > 0) snprintf(mode, sizeof(mode), "pipelined-%d", chunk);
+    else snprintf(mode, sizeof(mode), "%s", distributed ? "distributed" : "scatter");
+    MPI_Datatype storage_type = storage == ST_DOUBLE ? MPI_DOUBLE :
+                                storage == ST_FLOAT  ? MPI_FLOAT : MPI_UINT16_T;
+
     int N = atoi(argv[1]);
     if (N <= 0) {
         if (rank == 0) printf("Matrix size must be positive.\n");
@@ -48,12 +692,23 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    if (two_d) {
+        run2D(N, storage, rank, world_size);
+        MPI_Finalize();
+        return 0;
+    }
+    if (iters > 0) {
+        runIterative(N, storage, iters, rank, world_size);
+        MPI_Finalize();
+        return 0;
+    }
+
     /* ---- Compute row distribution (handles N % P != 0) ---- */
     int base_rows = N / world_size;
     int rem = N % world_size;
     int local_rows = base_rows + (rank < rem ? 1 : 0);
 
-    /* sendcounts / displs for Scatterv (in number of doubles) */
+    /* sendcounts / displs for Scatterv (in number of matrix elements) */
     int *sendcounts = (int *)malloc(world_size * sizeof(int));
     int *displs_A   = (int *)malloc(world_size * sizeof(int));
     /* recvcounts / rdispls for Gatherv (in number of doubles) */
@@ -62,85 +717,106 @@ int main(int argc, char *argv[]) {
 
     for (int r = 0, offset = 0; r < world_size; ++r) {
         int rows_r = base_rows + (r < rem ? 1 : 0);
-        sendcounts[r] = rows_r * N;
-        displs_A[r]   = offset * N;
+        sendcounts[r] = distributed ? 0 : rows_r * N;
+        displs_A[r]   = distributed ? 0 : offset * N;
         recvcounts[r]  = rows_r;
         rdispls[r]     = offset;
         offset += rows_r;
     }
 
     /* ---- Allocations ---- */
-    double *A          = NULL;  /* full matrix — root only */
+    double *A          = NULL;  /* full matrix — root only, scatter mode */
+    void   *A_stored   = NULL;  /* A in the storage format — root only */
     double *b          = (double *)malloc(N * sizeof(double));
     double *x_serial   = NULL;  /* serial result — root only */
     double *x_parallel = NULL;  /* gathered parallel result — root only */
 
     double t_serial = 0.0;
 
+    if (!b) {
+        fprintf(stderr, "Rank %d: failed to allocate b\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
     if (rank == 0) {
-        A          = (double *)malloc((size_t)N * N * sizeof(double));
         x_serial   = (double *)malloc(N * sizeof(double));
         x_parallel = (double *)malloc(N * sizeof(double));
 
-        if (!A || !b || !x_serial || !x_parallel) {
+        if (!x_serial || !x_parallel) {
             fprintf(stderr, "Memory allocation failed on root.\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
+    }
 
-        /* ---- Initialize A and b (same pattern from the assignment) ---- */
-        srand48(42);
-
-        /* Zero out A first */
-        for (int i = 0; i < N * N; ++i) A[i] = 0.0;
-
-        /* Fill A[0][:100] with random values */
-        int limit = (N < 100) ? N : 100;
-        for (int j = 0; j < limit; ++j)
-            A[0 * N + j] = drand48();
-
-        /* Copy A[0][:100] into A[1][100:200] if possible */
-        if (N > 1 && N > 100) {
-            int copy_len = (N - 100 < 100) ? (N - 100) : 100;
-            for (int j = 0; j < copy_len; ++j)
-                A[1 * N + (100 + j)] = A[0 * N + j];
+    if (distributed) {
+        /* b is cheap to generate everywhere; no broadcast needed */
+        generateVector(b, N);
+        if (rank == 0)
+            t_serial = matrixVectorMultBlockwise(b, x_serial, N);
+    } else if (rank == 0) {
+        A = (double *)malloc((size_t)N * N * sizeof(double));
+        if (!A) {
+            fprintf(stderr, "Memory allocation failed on root.\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
-        /* Set diagonal */
-        for (int i = 0; i < N; ++i)
-            A[i * N + i] = drand48();
-
-        /* Fill vector b */
-        for (int i = 0; i < N; ++i)
-            b[i] = drand48();
+        /* ---- Initialize A and b ---- */
+        generateRows(A, 0, N, N);
+        generateVector(b, N);
 
         /* ---- Serial computation for timing and verification ---- */
         double ts0 = MPI_Wtime();
         matrixVectorMult(A, b, x_serial, N, N);
         double ts1 = MPI_Wtime();
         t_serial = ts1 - ts0;
-    }
-
-    /* ---- Parallel computation ---- */
-    MPI_Barrier(MPI_COMM_WORLD);
-    double tp0 = MPI_Wtime();
 
-    /* Broadcast b to all processes */
-    MPI_Bcast(b, N, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        /* Compression is part of setup, like generating A */
+        A_stored = malloc((size_t)N * N * storage_bytes[storage]);
+        if (!A_stored) {
+            fprintf(stderr, "Memory allocation failed on root.\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        compressMatrix(A, A_stored, (size_t)N * N, storage);
+    }
 
-    /* Allocate local rows of A */
-    double *A_local = NULL;
-    if (local_rows > 0) {
-        A_local = (double *)malloc((size_t)local_rows * N * sizeof(double));
+    /* Local rows of A; generated in place (untimed setup) in --distributed.
+     * With --chunk root multiplies its rows straight from A_stored. */
+    void *A_local = NULL;
+    if (local_rows > 0 && !(chunk > 0 && rank == 0)) {
+        A_local = malloc((size_t)local_rows * N * storage_bytes[storage]);
         if (!A_local) {
             fprintf(stderr, "Rank %d: failed to allocate A_local\n", rank);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
+    if (distributed && local_rows > 0) {
+        double *row = (double *)malloc(N * sizeof(double));
+        if (!row) {
+            fprintf(stderr, "Rank %d: failed to allocate row buffer\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        for (int i = 0; i < local_rows; ++i) {
+            generateRows(row, rdispls[rank] + i, 1, N);
+            compressMatrix(row, (char *)A_local + (size_t)i * N * storage_bytes[storage],
+                           N, storage);
+        }
+        free(row);
+    }
 
-    /* Scatter rows of A */
-    MPI_Scatterv(A, sendcounts, displs_A, MPI_DOUBLE,
-                 A_local, local_rows * N, MPI_DOUBLE,
-                 0, MPI_COMM_WORLD);
+    /* ---- Parallel computation ---- */
+    MPI_Barrier(MPI_COMM_WORLD);
+    double tp0 = MPI_Wtime();
+
+    if (!distributed) {
+        /* Broadcast b to all processes */
+        MPI_Bcast(b, N, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    }
+    if (!distributed && chunk == 0) {
+        /* Scatter rows of A */
+        MPI_Scatterv(A_stored, sendcounts, displs_A, storage_type,
+                     A_local, local_rows * N, storage_type,
+                     0, MPI_COMM_WORLD);
+    }
 
     /* Local matrix-vector multiply */
     double *x_local = NULL;
@@ -150,7 +826,72 @@ int main(int argc, char *argv[]) {
             fprintf(stderr, "Rank %d: failed to allocate x_local\n", rank);
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
-        matrixVectorMult(A_local, b, x_local, local_rows, N);
+    }
+    if (chunk > 0) {
+        size_t row_bytes = (size_t)N * storage_bytes[storage];
+        int nchunks = (local_rows + chunk - 1) / chunk;
+        for (int i = 0; i < local_rows; ++i) x_local[i] = 0.0;
+
+        if (rank == 0) {
+            /* Chunk k of every rank before chunk k+1 of any, so that all
+             * ranks can start computing early */
+            int max_chunks = (base_rows + (rem > 0) + chunk - 1) / chunk;
+            MPI_Request *sreq = (MPI_Request *)malloc(((size_t)max_chunks * world_size + 1)
+                                                      * sizeof(MPI_Request));
+            int nsent = 0;
+            if (!sreq) {
+                fprintf(stderr, "Memory allocation failed on root.\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            for (int k = 0; k < max_chunks; ++k) {
+                for (int r = 1; r < world_size; ++r) {
+                    int first = k * chunk;
+                    if (first >= recvcounts[r]) continue;
+                    int len = (recvcounts[r] - first < chunk) ? (recvcounts[r] - first) : chunk;
+                    MPI_Isend((char *)A_stored + (size_t)(rdispls[r] + first) * row_bytes,
+                              len * N, storage_type, r, CHUNK_TAG, MPI_COMM_WORLD,
+                              &sreq[nsent++]);
+                }
+            }
+            /* Root's own rows need no transfer; MPI_Testall between row
+             * blocks drives the sends while it computes */
+            for (int r = 0; r < local_rows; r += PROGRESS_ROWS) {
+                int len = (local_rows - r < PROGRESS_ROWS) ? (local_rows - r) : PROGRESS_ROWS;
+                int done;
+                matrixVectorMultRange((char *)A_stored + r * row_bytes, b, x_local + r,
+                                      len, N, 0, N, storage);
+                MPI_Testall(nsent, sreq, &done, MPI_STATUSES_IGNORE);
+            }
+            MPI_Waitall(nsent, sreq, MPI_STATUSES_IGNORE);
+            free(sreq);
+        } else if (local_rows > 0) {
+            MPI_Request *rreq = (MPI_Request *)malloc(nchunks * sizeof(MPI_Request));
+            if (!rreq) {
+                fprintf(stderr, "Rank %d: allocation failed\n", rank);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            for (int k = 0; k < nchunks; ++k) {
+                int len = (local_rows - k * chunk < chunk) ? (local_rows - k * chunk) : chunk;
+                MPI_Irecv((char *)A_local + (size_t)k * chunk * row_bytes, len * N,
+                          storage_type, 0, CHUNK_TAG, MPI_COMM_WORLD, &rreq[k]);
+            }
+            /* Chunk k in row blocks, testing chunks k+1.. in between */
+            for (int k = 0; k < nchunks; ++k) {
+                int first = k * chunk;
+                int end = (local_rows - first < chunk) ? local_rows : first + chunk;
+                MPI_Wait(&rreq[k], MPI_STATUS_IGNORE);
+                for (int r = first; r < end; r += PROGRESS_ROWS) {
+                    int len = (end - r < PROGRESS_ROWS) ? (end - r) : PROGRESS_ROWS;
+                    int done;
+                    matrixVectorMultRange((char *)A_local + (size_t)r * row_bytes, b,
+                                          x_local + r, len, N, 0, N, storage);
+                    MPI_Testall(nchunks - k - 1, rreq + k + 1, &done, MPI_STATUSES_IGNORE);
+                }
+            }
+            free(rreq);
+        }
+    } else if (local_rows > 0) {
+        matrixVectorMultStored(A_local, b, x_local, local_rows, N, storage);
     }
 
     /* Gather results on root */
@@ -169,23 +910,28 @@ int main(int argc, char *argv[]) {
     /* ---- Root: verify and report ---- */
     if (rank == 0) {
         /* Compare parallel result with serial */
-        double max_error = 0.0;
+        double max_error = 0.0, max_rel_error = 0.0;
         for (int i = 0; i < N; ++i) {
             double diff = fabs(x_parallel[i] - x_serial[i]);
             if (diff > max_error) max_error = diff;
+            if (x_serial[i] != 0.0 && diff / fabs(x_serial[i]) > max_rel_error)
+                max_rel_error = diff / fabs(x_serial[i]);
         }
 
         double speedup    = t_serial / max_parallel_time;
-        double efficiency = speedup / world_size;
+        double efficiency = speedup / (world_size * num_threads);
 
-        printf("N=%d P=%d serial=%.6e parallel=%.6e speedup=%.4f efficiency=%.4f max_error=%e\n",
-               N, world_size, t_serial, max_parallel_time, speedup, efficiency, max_error);
+        printf("N=%d P=%d T=%d mode=%s storage=%s serial=%.6e parallel=%.6e speedup=%.4f efficiency=%.4f "
+               "max_error=%e max_rel_error=%e\n",
+               N, world_size, num_threads, mode, storage_names[storage], t_serial, max_parallel_time,
+               speedup, efficiency, max_error, max_rel_error);
 
         /* Append to CSV for plotting */
         FILE *f = fopen("timings.csv", "a");
         if (f) {
-            fprintf(f, "%d,%d,%.12e,%.12e,%.6f,%.6f,%e\n",
-                    N, world_size, t_serial, max_parallel_time, speedup, efficiency, max_error);
+            fprintf(f, "%d,%d,%.12e,%.12e,%.6f,%.6f,%e,%s,%s,%d\n",
+                    N, world_size, t_serial, max_parallel_time, speedup, efficiency, max_error,
+                    storage_names[storage], mode, num_threads);
             fclose(f);
         }
     }
@@ -194,6 +940,7 @@ int main(int argc, char *argv[]) {
     if (A_local) free(A_local);
     if (x_local) free(x_local);
     if (A) free(A);
+    if (A_stored) free(A_stored);
     free(b);
     if (x_serial)   free(x_serial);
     if (x_parallel) free(x_parallel);
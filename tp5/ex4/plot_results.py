@@ -17,6 +17,14 @@ if not os.path.exists(csv_path):
 
 df = pd.read_csv(csv_path)
 
+# Speedup / efficiency are plotted for the root-scattered double matrix
+if "storage" in df.columns:
+    df = df[df["storage"] == "double"]
+if "mode" in df.columns:
+    df = df[df["mode"] == "scatter"]
+if "threads" in df.columns:
+    df = df[df["threads"] == 1]
+
 # Get unique matrix sizes
 sizes = sorted(df["N"].unique())
 
@@ -6,22 +6,36 @@ set -euo pipefail
 EXE="./ex5"
 
 # Compile
-mpicc -O2 -o ex5 ex5.c -lm
+mpicc -O2 -fopenmp-simd -I../coll -o ex5 ex5.c ../coll/coll.c -lm
 
 # Clear previous results
-rm -f timings.csv
-echo "N,P,t_serial,t_parallel,speedup,efficiency,pi" > timings.csv
+rm -f timings.csv accuracy.csv
+echo "N,P,t_serial,t_parallel,speedup,efficiency,pi,method" > timings.csv
+echo "method,P,target,N,evaluations,time,error,reached" > accuracy.csv
 
 N_VALUES=(1000000 10000000 100000000)
 PROCS=(1 2 4 8)
+METHODS=(midpoint simd simpson richardson)
+TARGETS=(1e-8 1e-12)
 
-for N in "${N_VALUES[@]}"; do
+for METHOD in "${METHODS[@]}"; do
+    for N in "${N_VALUES[@]}"; do
+        for P in "${PROCS[@]}"; do
+            echo "Running: N=$N  P=$P  method=$METHOD"
+            mpirun --oversubscribe -np "$P" "$EXE" "$N" "$METHOD"
+        done
+    done
+done
+
+# Time-to-accuracy of every method across rank counts
+for EPS in "${TARGETS[@]}"; do
     for P in "${PROCS[@]}"; do
-        echo "Running: N=$N  P=$P"
-        mpirun --oversubscribe -np "$P" "$EXE" "$N"
+        echo "Running: target=$EPS  P=$P"
+        mpirun --oversubscribe -np "$P" "$EXE" --target "$EPS"
     done
 done
 
 echo ""
-echo "Results saved to timings.csv"
+echo "Results saved to timings.csv and accuracy.csv"
 cat timings.csv
+cat accuracy.csv
@@ -6,69 +6,256 @@
  *
  * - Iterations are split across processes (handles N % P != 0).
  * - Each process computes its local partial sum.
- * - MPI_Reduce sums partial results on root.
+ * - collReduce (tp5/coll) sums partial results on root.
  * - Root also computes the serial version for speedup measurement.
  * - Results are appended to timings.csv for plotting.
  *
- * Compile: mpicc -O2 -o ex5 ex5.c -lm
- * Run:     mpirun -np 4 ./ex5 10000000
+ * Methods (second argument):
+ *   midpoint    the loop above, scalar (default)
+ *   simd        same rule, vectorized: x from a double base plus an int
+ *               offset times h, and 1/(1 + x^2) from a float reciprocal
+ *               refined by two Newton steps
+ *   simpson     composite Simpson on N intervals, error O(h^4)
+ *   richardson  Romberg: trapezoid sums on N, N/2 and N/4 intervals from
+ *               one pass over the fine grid, extrapolated twice, O(h^6)
+ * Simpson and Richardson evaluate f on the N + 1 grid points i * h; N is
+ * rounded up to a multiple of 2 or 4.
+ *
+ * With --target EPS every method is run with N = 16, 32, ... until
+ * |pi - M_PI| <= EPS, and the N and time of the first run that reaches
+ * it are appended to accuracy.csv (time-to-accuracy).
+ *
+ * Compile: mpicc -O2 -fopenmp-simd -I../coll -o ex5 ex5.c ../coll/coll.c -lm
+ * Run:     mpirun -np 4 ./ex5 10000000 [midpoint|simd|simpson|richardson]
+ *          mpirun -np 4 ./ex5 --target 1e-12
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <mpi.h>
+#include "coll.h"
 
-int main(int argc, char *argv[]) {
-    long long N = 1000000; /* default number of intervals */
-    if (argc > 1) {
-        N = atoll(argv[1]);
+enum { M_MIDPOINT, M_SIMD, M_SIMPSON, M_RICHARDSON, NMETHODS };
+static const char *method_names[NMETHODS] = { "midpoint", "simd", "simpson", "richardson" };
+
+/* Largest N tried by --target */
+#define MAX_TARGET_N (1LL << 31)
+
+/* Iterations per block of the vectorized loops. Inside a block the
+ * induction variable is an int and x is built in double: a long long to
+ * double conversion has no vector form below AVX-512DQ. A multiple of 4. */
+#define SIMD_BLOCK (1 << 20)
+
+/* 1/d for d in [1, 2]: float reciprocal (~24 bits), two Newton steps
+ * (~48, then 53 bits). Vectorizes to single-precision division, which has
+ * twice the lanes of a double division, plus four multiply-adds. */
+#pragma omp declare simd
+static inline double recip(double d) {
+    double y = (double)(1.0f / (float)d);
+    y = y * (2.0 - d * y);
+    return y * (2.0 - d * y);
+}
+
+/* Midpoint sum over intervals [start, end), scalar (the original loop) */
+double midpointScalar(long long start, long long end, long long N) {
+    double sum = 0.0;
+    for (long long i = start; i < end; i++) {
+        double x = (i + 0.5) / (double)N;
+        sum += 1.0 / (1.0 + x * x);
     }
+    return sum;
+}
 
-    MPI_Init(&argc, &argv);
+/* Midpoint sum over intervals [start, end), vectorized */
+double midpointSimd(long long start, long long end, long long N) {
+    double h = 1.0 / (double)N, sum = 0.0;
+    for (long long i0 = start; i0 < end; i0 += SIMD_BLOCK) {
+        int len = end - i0 < SIMD_BLOCK ? (int)(end - i0) : SIMD_BLOCK;
+        double x0 = ((double)i0 + 0.5) * h;
+        #pragma omp simd reduction(+:sum)
+        for (int k = 0; k < len; k++) {
+            double x = x0 + (double)k * h;
+            sum += recip(1.0 + x * x);
+        }
+    }
+    return sum;
+}
 
-    int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
+/* f on grid points i * h, i in [start, end): sum over all points, over even
+ * points and over multiples of 4 (the grids of N, N/2 and N/4 intervals) */
+void gridSums(long long start, long long end, long long N, double sums[3]) {
+    double h = 1.0 / (double)N, s1 = 0.0, s2 = 0.0, s4 = 0.0;
+    for (long long i0 = start; i0 < end; i0 += SIMD_BLOCK) {
+        int len = end - i0 < SIMD_BLOCK ? (int)(end - i0) : SIMD_BLOCK;
+        int phase = (int)(i0 & 3);   /* i & 3 == (phase + k) & 3 */
+        double x0 = (double)i0 * h;
+        #pragma omp simd reduction(+:s1, s2, s4)
+        for (int k = 0; k < len; k++) {
+            double x = x0 + (double)k * h;
+            double f = recip(1.0 + x * x);
+            int m = (phase + k) & 3;
+            s1 += f;
+            s2 += (m & 1) ? 0.0 : f;
+            s4 += m ? 0.0 : f;
+        }
+    }
+    sums[0] = s1;
+    sums[1] = s2;
+    sums[2] = s4;
+}
 
-    /* ---- Parallel computation ---- */
+/* Pi from the three grid sums; f(0) = 1 and f(1) = 1/2 */
+double piFromGridSums(const double sums[3], long long N, int method) {
+    double ends = 0.5 * (1.0 + 0.5);
+    double h = 1.0 / (double)N;
+    double t1 = h * (sums[0] - ends);               /* trapezoid, N intervals */
+    double t2 = 2.0 * h * (sums[1] - ends);         /* N/2 intervals */
+    double simpson = (4.0 * t1 - t2) / 3.0;
+    if (method == M_SIMPSON) return 4.0 * simpson;
+
+    double t4 = 4.0 * h * (sums[2] - ends);         /* N/4 intervals */
+    double simpson_coarse = (4.0 * t2 - t4) / 3.0;
+    return 4.0 * (16.0 * simpson - simpson_coarse) / 15.0;
+}
+
+/* Round N up to what the method needs */
+long long adjustN(long long N, int method) {
+    long long m = method == M_SIMPSON ? 2 : method == M_RICHARDSON ? 4 : 1;
+    return (N + m - 1) / m * m;
+}
+
+/* Function evaluations of one run */
+long long evaluations(long long N, int method) {
+    return method == M_SIMPSON || method == M_RICHARDSON ? N + 1 : N;
+}
+
+/* Pi from the given range of intervals (midpoint) or grid points; on the
+ * full range this is the serial computation */
+double localPart(int method, long long start, long long end, long long N, double sums[3]) {
+    if (method == M_MIDPOINT || method == M_SIMD) {
+        sums[0] = method == M_MIDPOINT ? midpointScalar(start, end, N)
+                                       : midpointSimd(start, end, N);
+        sums[1] = sums[2] = 0.0;
+        return 4.0 / (double)N * sums[0];
+    }
+    gridSums(start, end, N, sums);
+    return piFromGridSums(sums, N, method);
+}
+
+/* Parallel run: returns pi on root and the max time over ranks in *t */
+double parallelPi(int method, long long N, int rank, int size, double *t) {
     MPI_Barrier(MPI_COMM_WORLD);
     double tp0 = MPI_Wtime();
 
-    /* Distribute iterations: handles N % size != 0 */
-    long long base_iters = N / size;
-    long long rem = N % size;
+    /* Distribute iterations: handles count % size != 0 */
+    long long count = evaluations(N, method);
+    long long base_iters = count / size;
+    long long rem = count % size;
     long long local_iters = base_iters + (rank < rem ? 1 : 0);
     long long start_i = rank * base_iters + (rank < rem ? rank : rem);
     long long end_i = start_i + local_iters;
 
-    double local_sum = 0.0;
-    for (long long i = start_i; i < end_i; i++) {
-        double x = (i + 0.5) / (double)N;
-        local_sum += 1.0 / (1.0 + x * x);
-    }
+    double local_sums[3], global_sums[3] = {0.0, 0.0, 0.0};
+    localPart(method, start_i, end_i, N, local_sums);
+    collReduce(local_sums, global_sums, 3, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
 
-    double global_sum = 0.0;
-    MPI_Reduce(&local_sum, &global_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    double pi = 0.0;
+    if (rank == 0) {
+        if (method == M_MIDPOINT || method == M_SIMD)
+            pi = 4.0 / (double)N * global_sums[0];
+        else
+            pi = piFromGridSums(global_sums, N, method);
+    }
 
-    double tp1 = MPI_Wtime();
-    double t_parallel = tp1 - tp0;
+    double t_parallel = MPI_Wtime() - tp0;
 
     /* Get the maximum parallel time across all processes */
-    double max_parallel_time = 0.0;
-    MPI_Reduce(&t_parallel, &max_parallel_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&t_parallel, t, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    return pi;
+}
 
+/* Time-to-accuracy of every method for the given error target */
+void timeToAccuracy(double target, int rank, int size) {
     if (rank == 0) {
-        double pi_parallel = 4.0 / (double)N * global_sum;
+        printf("Target |pi - M_PI| <= %.1e, P=%d\n", target, size);
+        printf("  %-11s %14s %14s %12s %10s\n", "method", "N", "evaluations", "time (s)", "error");
+    }
+
+    for (int method = 0; method < NMETHODS; ++method) {
+        long long N = 16;
+        double pi = 0.0, t = 0.0, error = INFINITY;
+        while (N <= MAX_TARGET_N) {
+            pi = parallelPi(method, N, rank, size, &t);
+            if (rank == 0) error = fabs(pi - M_PI);
+            MPI_Bcast(&error, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            if (error <= target) break;
+            N *= 2;
+        }
+
+        if (rank == 0) {
+            int reached = error <= target;
+            printf("  %-11s %14lld %14lld %12.6e %10.2e%s\n", method_names[method], N,
+                   evaluations(N, method), t, error, reached ? "" : "  (not reached)");
 
+            FILE *f = fopen("accuracy.csv", "a");
+            if (f) {
+                fprintf(f, "%s,%d,%.3e,%lld,%lld,%.12e,%.3e,%d\n", method_names[method], size,
+                        target, N, evaluations(N, method), t, error, reached);
+                fclose(f);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long long N = 1000000; /* default number of intervals */
+    int method = M_MIDPOINT;
+    double target = 0.0;
+
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    for (int a = 1; a < argc; a++) {
+        int m;
+        for (m = 0; m < NMETHODS; m++)
+            if (strcmp(argv[a], method_names[m]) == 0) break;
+        if (m < NMETHODS) {
+            method = m;
+        } else if (strcmp(argv[a], "--target") == 0 && a + 1 < argc) {
+            target = atof(argv[++a]);
+        } else if (atoll(argv[a]) > 0) {
+            N = atoll(argv[a]);
+        } else {
+            if (rank == 0)
+                printf("Usage: %s [N] [midpoint|simd|simpson|richardson] [--target EPS]\n",
+                       argv[0]);
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    if (target > 0.0) {
+        timeToAccuracy(target, rank, size);
+        MPI_Finalize();
+        return 0;
+    }
+
+    N = adjustN(N, method);
+
+    /* ---- Parallel computation ---- */
+    double max_parallel_time = 0.0;
+    double pi_parallel = parallelPi(method, N, rank, size, &max_parallel_time);
+
+    if (rank == 0) {
         /* ---- Serial computation for speedup reference ---- */
         double ts0 = MPI_Wtime();
-        double serial_sum = 0.0;
-        for (long long i = 0; i < N; i++) {
-            double x = (i + 0.5) / (double)N;
-            serial_sum += 1.0 / (1.0 + x * x);
-        }
-        double pi_serial = 4.0 / (double)N * serial_sum;
+        double sums[3];
+        double pi_serial = localPart(method, 0, evaluations(N, method), N, sums);
         double ts1 = MPI_Wtime();
         double t_serial = ts1 - ts0;
 
@@ -78,14 +265,16 @@ int main(int argc, char *argv[]) {
         double speedup = t_serial / max_parallel_time;
         double efficiency = speedup / size;
 
-        printf("N=%lld P=%d pi=%.15f error=%.2e serial_error=%.2e serial=%.6e parallel=%.6e speedup=%.4f efficiency=%.4f\n",
-               N, size, pi_parallel, error, serial_error, t_serial, max_parallel_time, speedup, efficiency);
+        printf("N=%lld P=%d method=%s pi=%.15f error=%.2e serial_error=%.2e serial=%.6e parallel=%.6e speedup=%.4f efficiency=%.4f\n",
+               N, size, method_names[method], pi_parallel, error, serial_error, t_serial,
+               max_parallel_time, speedup, efficiency);
 
         /* Append to CSV for plotting */
         FILE *f = fopen("timings.csv", "a");
         if (f) {
-            fprintf(f, "%lld,%d,%.12e,%.12e,%.6f,%.6f,%.15f\n",
-                    N, size, t_serial, max_parallel_time, speedup, efficiency, pi_parallel);
+            fprintf(f, "%lld,%d,%.12e,%.12e,%.6f,%.6f,%.15f,%s\n",
+                    N, size, t_serial, max_parallel_time, speedup, efficiency, pi_parallel,
+                    method_names[method]);
             fclose(f);
         }
     }
@@ -17,6 +17,10 @@ if not os.path.exists(csv_path):
 
 df = pd.read_csv(csv_path)
 
+# Speedup plots use the original midpoint loop
+if "method" in df.columns:
+    df = df[df["method"] == "midpoint"]
+
 # Get unique N values
 N_values = sorted(df["N"].unique())
 
@@ -53,3 +57,27 @@ plt.tight_layout()
 plt.savefig("speedup_efficiency_ex5.png", dpi=150)
 plt.show()
 print("Plot saved to speedup_efficiency_ex5.png")
+
+# --- Time-to-accuracy Plot ---
+acc_path = os.path.join(os.path.dirname(__file__), "accuracy.csv")
+if os.path.exists(acc_path):
+    acc = pd.read_csv(acc_path)
+    acc = acc[acc["reached"] == 1]
+    targets = sorted(acc["target"].unique(), reverse=True)
+
+    fig, axes = plt.subplots(1, len(targets), figsize=(7 * len(targets), 6), squeeze=False)
+    for ax, target in zip(axes[0], targets):
+        for method in acc["method"].unique():
+            subset = acc[(acc["target"] == target) & (acc["method"] == method)].sort_values("P")
+            ax.plot(subset["P"], subset["time"], "o-", label=method)
+        ax.set_xlabel("Number of Processes (P)")
+        ax.set_ylabel("Time to accuracy (s)")
+        ax.set_yscale("log")
+        ax.set_title(f"Pi Calculation — time to |error| <= {target:.0e}")
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig("time_to_accuracy_ex5.png", dpi=150)
+    plt.show()
+    print("Plot saved to time_to_accuracy_ex5.png")
@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Benchmark script for the point-to-point suite
+# Usage: bash benchmark.sh
+set -euo pipefail
+
+EXE="./p2p"
+
+# Compile
+mpicc -O2 -o p2p p2p.c
+
+# Clear previous results
+rm -f p2p.csv
+echo "test,mode,transport,bytes,P,value,unit" > p2p.csv
+
+# Intra-node shared memory vs TCP loopback
+SHM=(--mca btl self,vader)
+LOOPBACK=(--mca btl self,tcp --mca btl_tcp_if_include lo)
+MAX_BYTES=4194304
+
+echo "Running: all tests, shared memory"
+mpirun --oversubscribe "${SHM[@]}" -np 2 "$EXE" --max-bytes "$MAX_BYTES" --transport shm
+echo "Running: all tests, loopback"
+mpirun --oversubscribe "${LOOPBACK[@]}" -np 2 "$EXE" --max-bytes "$MAX_BYTES" --transport loopback
+
+# Message rate with more pairs
+for P in 4 8; do
+    echo "Running: message rate, P=$P"
+    mpirun --oversubscribe "${SHM[@]}" -np "$P" "$EXE" --test mr --max-bytes 65536 --transport shm
+done
+
+echo ""
+echo "Results saved to p2p.csv"
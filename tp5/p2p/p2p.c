@@ -0,0 +1,314 @@
+/*
+ * TP5 - Point-to-Point Benchmarks (OSU-style)
+ *
+ * Measures the MPI transport under the tp5 exercises:
+ *   latency  ping-pong between ranks 0 and 1, half round-trip time
+ *   bw       unidirectional bandwidth: rank 0 sends WINDOW messages back to
+ *            back, rank 1 acknowledges the window
+ *   bibw     bidirectional bandwidth: both ranks send a window at once
+ *   mr       message rate: ranks i < P/2 each stream windows to i + P/2,
+ *            messages per second summed over the pairs
+ *   eager    eager/rendezvous threshold: rank 1 posts its receive only
+ *            DELAY_MS after rank 0 calls send. An eager send returns at once
+ *            (the data is buffered); a rendezvous send waits for the receive.
+ *            A send is eager if it took less than EAGER_CUTOFF_US; the
+ *            threshold is written to p2p.csv as an "eager_threshold" row.
+ * Each test runs with blocking (MPI_Send/MPI_Recv, MPI_Sendrecv for bibw)
+ * and nonblocking (MPI_Isend/MPI_Irecv + MPI_Waitall) calls, for message
+ * sizes 1 B .. --max-bytes. Nonblocking ping-pong keeps a receive posted
+ * before the matching send; eager runs blocking only, since a send followed
+ * by its wait is the same measurement.
+ *
+ * The transport is chosen by mpirun, e.g. shared memory vs TCP loopback:
+ *   mpirun --mca btl self,vader -np 2 ./p2p --transport shm
+ *   mpirun --mca btl self,tcp --mca btl_tcp_if_include lo -np 2 ./p2p --transport loopback
+ * --transport only labels the rows of p2p.csv.
+ *
+ * Compile: mpicc -O2 -o p2p p2p.c
+ * Run:     mpirun -np 2 ./p2p [--test latency|bw|bibw|mr|eager|all]
+ *                             [--mode blocking|nonblocking|both]
+ *                             [--max-bytes B] [--transport LABEL]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#define DEFAULT_MAX_BYTES (1L << 20)
+#define WINDOW 64            /* messages in flight per bw/bibw/mr window */
+#define LARGE_MSG 8192       /* fewer iterations above this size */
+#define ITERS_SMALL 1000     /* ping-pongs per size */
+#define ITERS_LARGE 100
+#define WINDOWS_SMALL 100    /* windows per size for bw/bibw/mr */
+#define WINDOWS_LARGE 20
+#define SKIP_DIV 10          /* untimed warm-up: 1/SKIP_DIV of the iterations */
+#define DELAY_MS 20.0        /* receiver delay for eager detection */
+#define EAGER_CUTOFF_US (0.5 * DELAY_MS * 1e3)  /* faster sends were eager */
+
+enum { T_LATENCY, T_BW, T_BIBW, T_MR, T_EAGER, NTESTS };
+static const char *test_names[NTESTS] = { "latency", "bw", "bibw", "mr", "eager" };
+static const char *test_units[NTESTS] = { "us", "MB/s", "MB/s", "msg/s", "us" };
+
+static char *sbuf, *rbuf;    /* WINDOW slots of max_bytes each */
+
+/* Ping-pong between ranks 0 and 1; returns the elapsed time on rank 0.
+ * Nonblocking: every message finds its receive already posted (rank 0 posts
+ * it before its send, rank 1 reposts before its reply), as in bibw. */
+double pingPong(long n, int iters, int blocking, int rank) {
+    MPI_Request req[2];
+    double t0 = MPI_Wtime();
+    if (!blocking && rank == 1 && iters > 0)
+        MPI_Irecv(rbuf, (int)n, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &req[1]);
+    for (int i = 0; i < iters; i++) {
+        if (rank == 0) {
+            if (blocking) {
+                MPI_Send(sbuf, (int)n, MPI_CHAR, 1, 0, MPI_COMM_WORLD);
+                MPI_Recv(rbuf, (int)n, MPI_CHAR, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            } else {
+                MPI_Irecv(rbuf, (int)n, MPI_CHAR, 1, 0, MPI_COMM_WORLD, &req[1]);
+                MPI_Isend(sbuf, (int)n, MPI_CHAR, 1, 0, MPI_COMM_WORLD, &req[0]);
+                MPI_Waitall(2, req, MPI_STATUSES_IGNORE);
+            }
+        } else if (rank == 1) {
+            if (blocking) {
+                MPI_Recv(rbuf, (int)n, MPI_CHAR, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Send(sbuf, (int)n, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+            } else {
+                MPI_Wait(&req[1], MPI_STATUS_IGNORE);
+                if (i + 1 < iters)
+                    MPI_Irecv(rbuf, (int)n, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &req[1]);
+                MPI_Isend(sbuf, (int)n, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &req[0]);
+                MPI_Wait(&req[0], MPI_STATUS_IGNORE);
+            }
+        }
+    }
+    return MPI_Wtime() - t0;
+}
+
+/* Send one window of n-byte messages to peer; each message has its own slot */
+static void sendWindow(long n, int peer, int blocking) {
+    MPI_Request req[WINDOW];
+    for (int w = 0; w < WINDOW; w++) {
+        if (blocking)
+            MPI_Send(sbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD);
+        else
+            MPI_Isend(sbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD, &req[w]);
+    }
+    if (!blocking) MPI_Waitall(WINDOW, req, MPI_STATUSES_IGNORE);
+}
+
+static void recvWindow(long n, int peer, int blocking) {
+    MPI_Request req[WINDOW];
+    for (int w = 0; w < WINDOW; w++) {
+        if (blocking)
+            MPI_Recv(rbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        else
+            MPI_Irecv(rbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD, &req[w]);
+    }
+    if (!blocking) MPI_Waitall(WINDOW, req, MPI_STATUSES_IGNORE);
+}
+
+/* Windows from sender to receiver, each acknowledged by a zero-byte message;
+ * used by bw (ranks 0 -> 1) and mr (every pair). Returns elapsed time. */
+double streamWindows(long n, int windows, int blocking, int sender, int receiver, int rank) {
+    double t0 = MPI_Wtime();
+    for (int i = 0; i < windows; i++) {
+        if (rank == sender) {
+            sendWindow(n, receiver, blocking);
+            MPI_Recv(NULL, 0, MPI_CHAR, receiver, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        } else if (rank == receiver) {
+            recvWindow(n, sender, blocking);
+            MPI_Send(NULL, 0, MPI_CHAR, sender, 2, MPI_COMM_WORLD);
+        }
+    }
+    return MPI_Wtime() - t0;
+}
+
+/* Both ranks 0 and 1 send and receive a window at once */
+double exchangeWindows(long n, int windows, int blocking, int rank) {
+    if (rank > 1) return 0.0;
+    int peer = 1 - rank;
+    MPI_Request req[2 * WINDOW];
+    double t0 = MPI_Wtime();
+    for (int i = 0; i < windows; i++) {
+        for (int w = 0; w < WINDOW; w++) {
+            if (blocking) {
+                MPI_Sendrecv(sbuf + w * n, (int)n, MPI_CHAR, peer, 1,
+                             rbuf + w * n, (int)n, MPI_CHAR, peer, 1,
+                             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            } else {
+                MPI_Irecv(rbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD, &req[w]);
+                MPI_Isend(sbuf + w * n, (int)n, MPI_CHAR, peer, 1, MPI_COMM_WORLD, &req[WINDOW + w]);
+            }
+        }
+        if (!blocking) MPI_Waitall(2 * WINDOW, req, MPI_STATUSES_IGNORE);
+    }
+    return MPI_Wtime() - t0;
+}
+
+/* Time of one send of n bytes while the receive is posted DELAY_MS late */
+double delayedSend(long n, int rank) {
+    double dt = 0.0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) {
+        double t0 = MPI_Wtime();
+        MPI_Send(sbuf, (int)n, MPI_CHAR, 1, 3, MPI_COMM_WORLD);
+        dt = MPI_Wtime() - t0;
+    } else if (rank == 1) {
+        double t0 = MPI_Wtime();
+        while (MPI_Wtime() - t0 < DELAY_MS * 1e-3) {}
+        MPI_Recv(rbuf, (int)n, MPI_CHAR, 0, 3, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    return dt;
+}
+
+/* Runs one test for one size; returns the value in test_units on rank 0 */
+double runTest(int test, long n, int blocking, int rank, int size) {
+    int small = n <= LARGE_MSG;
+    int iters = small ? ITERS_SMALL : ITERS_LARGE;
+    int windows = small ? WINDOWS_SMALL : WINDOWS_LARGE;
+    double t = 0.0, t_max = 0.0;
+
+    switch (test) {
+    case T_LATENCY:
+        pingPong(n, iters / SKIP_DIV, blocking, rank);
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = pingPong(n, iters, blocking, rank);
+        return t / (2.0 * iters) * 1e6;
+    case T_BW:
+        streamWindows(n, windows / SKIP_DIV, blocking, 0, 1, rank);
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = streamWindows(n, windows, blocking, 0, 1, rank);
+        return (double)n * WINDOW * windows / t / 1e6;
+    case T_BIBW:
+        exchangeWindows(n, windows / SKIP_DIV, blocking, rank);
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = exchangeWindows(n, windows, blocking, rank);
+        return 2.0 * n * WINDOW * windows / t / 1e6;
+    case T_MR: {
+        /* With odd P the last rank stays idle */
+        int pairs = size / 2;
+        int sender = rank < pairs ? rank : rank - pairs;
+        int receiver = sender + pairs;
+        int active = rank < 2 * pairs;
+        if (active) streamWindows(n, windows / SKIP_DIV, blocking, sender, receiver, rank);
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (active) t = streamWindows(n, windows, blocking, sender, receiver, rank);
+        MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        return (double)pairs * WINDOW * windows / t_max;
+    }
+    case T_EAGER:
+        return delayedSend(n, rank) * 1e6;
+    }
+    return 0.0;
+}
+
+int main(int argc, char *argv[]) {
+    long max_bytes = DEFAULT_MAX_BYTES;
+    const char *transport = "default";
+    int only_test = -1;          /* -1: all tests */
+    int mode_lo = 0, mode_hi = 1; /* 0: blocking, 1: nonblocking */
+    int rank, size;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int bad_args = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--test") == 0 && a + 1 < argc) {
+            const char *name = argv[++a];
+            only_test = -2;
+            for (int t = 0; t < NTESTS; t++)
+                if (strcmp(name, test_names[t]) == 0) only_test = t;
+            if (strcmp(name, "all") == 0) only_test = -1;
+            if (only_test == -2) bad_args = 1;
+        } else if (strcmp(argv[a], "--mode") == 0 && a + 1 < argc) {
+            const char *mode = argv[++a];
+            if (strcmp(mode, "blocking") == 0) mode_hi = 0;
+            else if (strcmp(mode, "nonblocking") == 0) mode_lo = 1;
+            else if (strcmp(mode, "both") != 0) bad_args = 1;
+        } else if (strcmp(argv[a], "--max-bytes") == 0 && a + 1 < argc) {
+            max_bytes = atol(argv[++a]);
+        } else if (strcmp(argv[a], "--transport") == 0 && a + 1 < argc) {
+            transport = argv[++a];
+        } else {
+            bad_args = 1;
+        }
+    }
+    if (bad_args || max_bytes < 1) {
+        if (rank == 0)
+            printf("Usage: %s [--test latency|bw|bibw|mr|eager|all] "
+                   "[--mode blocking|nonblocking|both] [--max-bytes B] [--transport LABEL]\n",
+                   argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+    if (size < 2) {
+        if (rank == 0) fprintf(stderr, "Error: need at least 2 processes\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    sbuf = malloc(WINDOW * max_bytes);
+    rbuf = malloc(WINDOW * max_bytes);
+    if (!sbuf || !rbuf) {
+        fprintf(stderr, "Rank %d: cannot allocate 2 x %d x %ld bytes\n", rank, WINDOW, max_bytes);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    memset(sbuf, 'a', WINDOW * max_bytes);
+    memset(rbuf, 0, WINDOW * max_bytes);
+
+    FILE *f = NULL;
+    if (rank == 0) {
+        printf("Point-to-point benchmarks, P=%d, transport=%s, sizes 1 B .. %ld B\n",
+               size, transport, max_bytes);
+        f = fopen("p2p.csv", "a");
+    }
+
+    for (int test = 0; test < NTESTS; test++) {
+        if (only_test >= 0 && test != only_test) continue;
+        for (int mode = mode_lo; mode <= mode_hi; mode++) {
+            int blocking = mode == 0;
+            if (test == T_EAGER && !blocking) continue;
+            const char *mode_name = blocking ? "blocking" : "nonblocking";
+            long threshold = 0;  /* eager: largest size whose send did not wait */
+
+            if (rank == 0)
+                printf("\n--- %s (%s) ---\n%12s %14s\n", test_names[test], mode_name,
+                       "bytes", test_units[test]);
+
+            for (long n = 1; n <= max_bytes; n *= 2) {
+                double value = runTest(test, n, blocking, rank, size);
+                MPI_Barrier(MPI_COMM_WORLD);
+                if (rank != 0) continue;
+
+                if (test == T_EAGER) {
+                    int eager = value < EAGER_CUTOFF_US;
+                    if (eager && threshold == n / 2) threshold = n;
+                    printf("%12ld %14.2f  %s\n", n, value, eager ? "eager" : "rendezvous");
+                } else {
+                    printf("%12ld %14.2f\n", n, value);
+                }
+                if (f)
+                    fprintf(f, "%s,%s,%s,%ld,%d,%.6f,%s\n", test_names[test], mode_name,
+                            transport, n, size, value, test_units[test]);
+            }
+
+            if (rank == 0 && test == T_EAGER) {
+                printf("Eager threshold: %ld bytes (sends up to this size do not wait "
+                       "for the receive)\n", threshold);
+                if (f)
+                    fprintf(f, "eager_threshold,%s,%s,%ld,%d,%ld,bytes\n", mode_name,
+                            transport, threshold, size, threshold);
+            }
+        }
+    }
+
+    if (f) fclose(f);
+    free(sbuf);
+    free(rbuf);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,47 @@
+"""
+Plot latency, bandwidth and message rate for the point-to-point suite.
+Reads p2p.csv (generated by benchmark.sh) and produces one figure.
+
+Usage: python plot_results.py
+"""
+
+import pandas as pd
+import matplotlib.pyplot as plt
+import os
+
+csv_path = os.path.join(os.path.dirname(__file__), "p2p.csv")
+
+if not os.path.exists(csv_path):
+    print(f"Error: {csv_path} not found. Run benchmark.sh first.")
+    exit(1)
+
+df = pd.read_csv(csv_path)
+
+tests = [("latency", "Latency (us)"), ("bw", "Bandwidth (MB/s)"),
+         ("bibw", "Bidirectional bandwidth (MB/s)"), ("mr", "Message rate (msg/s)")]
+
+fig, axes = plt.subplots(2, 2, figsize=(14, 10))
+
+for ax, (test, ylabel) in zip(axes.flat, tests):
+    data = df[df["test"] == test]
+    for (transport, mode, P), subset in data.groupby(["transport", "mode", "P"]):
+        subset = subset.sort_values("bytes")
+        label = f"{transport}, {mode}" + (f", P={P}" if test == "mr" else "")
+        ax.plot(subset["bytes"], subset["value"], "o-", markersize=3, label=label)
+    ax.set_xscale("log", base=2)
+    ax.set_yscale("log")
+    ax.set_xlabel("Message size (bytes)")
+    ax.set_ylabel(ylabel)
+    ax.set_title(f"Point-to-point — {test}")
+    ax.legend()
+    ax.grid(True, alpha=0.3)
+
+plt.tight_layout()
+plt.savefig("p2p.png", dpi=150)
+plt.show()
+print("Plot saved to p2p.png")
+
+# --- Eager/rendezvous thresholds, as classified by p2p ---
+thresholds = df[df["test"] == "eager_threshold"]
+for _, row in thresholds.iterrows():
+    print(f"Eager threshold ({row['transport']}, {row['mode']}): {int(row['value'])} bytes")
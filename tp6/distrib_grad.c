@@ -6,11 +6,13 @@
  * (feature vector + label).  The dataset is generated on process 0 and
  * scattered with MPI_Scatterv.  Each process computes a local gradient
  * and loss; global reduction updates the weights synchronously.
+ * The reduction goes through collAllreduce (tp5/coll), which picks the
+ * algorithm from the tuning table named by COLL_TUNING.
  *
  * Model:  y = w[0]*x[0] + w[1]*x[1] + ... + w[N_FEATURES-1]*x[N_FEATURES-1] + bias
  *         (bias absorbed into w[N_FEATURES] with a constant feature = 1)
  *
- * Compile: mpicc -O2 -Wall -o distrib_grad distrib_grad.c -lm
+ * Compile: mpicc -O2 -Wall -I../tp5/coll -o distrib_grad distrib_grad.c ../tp5/coll/coll.c -lm
  * Run:     mpirun -np 4 ./distrib_grad [N_SAMPLES]
  */
 
@@ -19,6 +21,7 @@
 #include <string.h>
 #include <math.h>
 #include <mpi.h>
+#include "coll.h"
 
 /* ---------- tunables ---------- */
 #define N_FEATURES   2          /* number of features (excluding bias) */
@@ -159,9 +162,9 @@ int main(int argc, char *argv[])
 
         /* ---- Allreduce gradient and loss ---- */
         double global_grad[DIM];
-        MPI_Allreduce(local_grad, global_grad, DIM, MPI_DOUBLE,
+        collAllreduce(local_grad, global_grad, DIM, MPI_DOUBLE,
                       MPI_SUM, MPI_COMM_WORLD);
-        MPI_Allreduce(&local_loss, &global_loss, 1, MPI_DOUBLE,
+        collAllreduce(&local_loss, &global_loss, 1, MPI_DOUBLE,
                       MPI_SUM, MPI_COMM_WORLD);
 
         /* MSE */
@@ -17,7 +17,7 @@ PROCS_LIST="1 2 4 7 8 14 16 28 32 56"
 # Compile if necessary
 if [ ! -f "$BINARY" ]; then
     echo "Compiling distrib_grad..."
-    mpicc -O2 -Wall -std=c99 -o distrib_grad distrib_grad.c -lm
+    mpicc -O2 -Wall -std=c99 -I../tp5/coll -o distrib_grad distrib_grad.c ../tp5/coll/coll.c -lm
 fi
 
 echo "Benchmark: N_SAMPLES=$N_SAMPLES"
@@ -17,7 +17,7 @@ module load matplotlib/3.7.2-gfbf-2023a
 cd $SLURM_SUBMIT_DIR
 
 # Compile
-mpicc -O2 -Wall -std=c99 -o distrib_grad distrib_grad.c -lm
+mpicc -O2 -Wall -std=c99 -I../tp5/coll -o distrib_grad distrib_grad.c ../tp5/coll/coll.c -lm
 
 N_SAMPLES=${1:-10000000}
 BINARY="./distrib_grad"